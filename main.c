@@ -3,9 +3,8 @@
 #include <math.h>
 #include <float.h>
 #include <string.h>
-#define MAXN 25
+#include <stdint.h>
 #define PI 3.14159265358979323846
-#define MAXV 700 // At most N + 2*(N choose 2) <= 25 + 600 = 625 nodes
 #define INF 1e100
 static const double EARTH_R = 6370.0;
 
@@ -56,6 +55,44 @@ static void sph2vec(double lon_deg,double lat_deg, Vec *v){
     v->z = sl;
 }
 
+// Per-case working storage, sized from the case's N and reused by later cases.
+// Buffers only ever grow, so a run of same-sized cases allocates once.
+typedef struct {
+    Vec *airports; size_t airports_cap;
+    Vec *V; size_t V_cap;           // nodes: N airports + up to 2*(N choose 2) intersections
+    double *D; size_t D_cap;        // Vn x Vn distances, row-major
+    double (*ivs)[2]; size_t ivs_cap; // coverage intervals of one arc, at most 2 per airport
+    double *distN; size_t distN_cap;
+    int *used; size_t used_cap;
+} Arena;
+
+// Make *buf hold at least n elements of size elem; exits with a message if memory runs out
+static void reserve(void **buf, size_t *cap, size_t n, size_t elem){
+    if(n <= *cap) return;
+    if(n > SIZE_MAX / elem){
+        fprintf(stderr, "case too large: %zu elements of %zu bytes\n", n, elem);
+        exit(1);
+    }
+    void *p = realloc(*buf, n * elem);
+    if(!p){
+        fprintf(stderr, "out of memory allocating %zu bytes\n", n * elem);
+        exit(1);
+    }
+    *buf = p;
+    *cap = n;
+}
+#define RESERVE(arena, field, n) reserve((void **)&(arena)->field, &(arena)->field##_cap, (n), sizeof(*(arena)->field))
+
+static void arena_free(Arena *arena){
+    free(arena->airports); free(arena->V); free(arena->D);
+    free(arena->ivs); free(arena->distN); free(arena->used);
+}
+
+// Row i of the Vn x Vn row-major distance matrix D
+static inline double *dist_row(double *D, size_t Vn, size_t i){
+    return D + i*Vn;
+}
+
 // comparison function for qsort
 static int compare_intervals(const void *a, const void *b) {
     const double *ia = (const double *)a;
@@ -67,11 +104,25 @@ static int compare_intervals(const void *a, const void *b) {
 
 int main(){
     int N, caseNo=1;
+    Arena arena = {0};
     while(scanf("%d",&N)==1){
         int R; 
-        if(N==0) break;
+        if(N<=0) break;
         scanf("%d",&R);
-        Vec airports[MAXN];
+        size_t n = (size_t)N;
+        RESERVE(&arena, airports, n);
+        // N airports plus up to 2*(N choose 2) intersections; refuse counts size_t cannot hold
+        if(n > 1 && n - 1 > (SIZE_MAX - n) / n){
+            fprintf(stderr, "case too large: %d airports\n", N);
+            exit(1);
+        }
+        RESERVE(&arena, V, n + n*(n-1));
+        RESERVE(&arena, ivs, 2*n);
+        RESERVE(&arena, distN, n);
+        RESERVE(&arena, used, n);
+        Vec *airports = arena.airports;
+        Vec *V = arena.V;
+        double (*ivs)[2] = arena.ivs;
         for(int i=0;i<N;i++){
             double lon,lat;
             scanf("%lf%lf",&lon,&lat);
@@ -82,12 +133,9 @@ int main(){
         double cosA = cos(alpha);
 
         // build node list
-        Vec V[MAXV];
-        int isAirport[MAXV]={0};
-        int Vn = 0;
+        size_t Vn = 0;
         for(int i=0;i<N;i++){
-            V[Vn] = airports[i];
-            isAirport[Vn++] = 1;
+            V[Vn++] = airports[i];
         }
         // intersections of safety-circle boundaries
         for(int i=0;i<N;i++) for(int j=i+1;j<N;j++){
@@ -123,15 +171,22 @@ int main(){
             V[Vn++] = i2;
         }
         // prepare adjacency: initially INF
-        static double D[MAXV][MAXV];
-        for(int i=0;i<Vn;i++) for(int j=0;j<Vn;j++)
-            D[i][j] = (i==j? 0.0 : INF);
+        if(Vn > SIZE_MAX / Vn){
+            fprintf(stderr, "case too large: %zu nodes\n", Vn);
+            exit(1);
+        }
+        RESERVE(&arena, D, Vn*Vn);
+        double *D = arena.D;
+        for(size_t i=0;i<Vn;i++){
+            double *Di = dist_row(D,Vn,i);
+            for(size_t j=0;j<Vn;j++) Di[j] = (i==j? 0.0 : INF);
+        }
 
         // For each pair of nodes a,b, test whether arc lies inside union of caps
         // We'll parameterize arc from a->b by angle θ in [0,θ_ab], and for each airport
         // compute the interval of θ for which dot(P(θ),Ai)>=cosA, build union and check cover.
         Vec abU, abW;
-        for(int a=0;a<Vn;a++) for(int b=a+1;b<Vn;b++){
+        for(size_t a=0;a<Vn;a++) for(size_t b=a+1;b<Vn;b++){
             // great circle angle between V[a],V[b]
             double cab = dot(&V[a],&V[b]);
             if(cab>1) cab=1; else if(cab<-1) cab=-1;
@@ -143,8 +198,7 @@ int main(){
             scale(&tmp, 1.0/sin(theta_ab));
             abW = tmp;
             // gather coverage intervals on [0,θ_ab]
-            // at most N intervals
-            static double ivs[2*MAXN][2];
+            // at most 2N intervals
             int ivn=0;
             for(int i=0;i<N;i++){
                 // we want dot( cosθ U + sinθ W , Ai ) >= cosA
@@ -207,25 +261,23 @@ int main(){
             if(reach >= theta_ab - 1e-12){
                 // covered => valid edge
                 double dist_km = theta_ab * EARTH_R;
-                D[a][b] = D[b][a] = dist_km;
+                dist_row(D,Vn,a)[b] = dist_row(D,Vn,b)[a] = dist_km;
             }
         }
 
         // Floyd–Warshall on node graph
-        for(int k=0;k<Vn;k++)
-        for(int i=0;i<Vn;i++){
-            if(D[i][k]>=INF) continue;
-            for(int j=0;j<Vn;j++){
-                double via = D[i][k] + D[k][j];
-                if(via < D[i][j]) D[i][j] = via;
+        for(size_t k=0;k<Vn;k++)
+        for(size_t i=0;i<Vn;i++){
+            double *Di = dist_row(D,Vn,i);
+            if(Di[k]>=INF) continue;
+            const double *Dk = dist_row(D,Vn,k);
+            for(size_t j=0;j<Vn;j++){
+                double via = Di[k] + Dk[j];
+                if(via < Di[j]) Di[j] = via;
             }
         }
 
-        // Extract airport-to-airport distances
-        static double AtoA[MAXN][MAXN];
-        for(int i=0;i<N;i++) for(int j=0;j<N;j++){
-            AtoA[i][j] = D[i][j];
-        }
+        // Airport-to-airport distances are the top-left N x N block of D (airports come first)
 
         // handle queries
         int Q; scanf("%d",&Q);
@@ -235,8 +287,8 @@ int main(){
             scanf("%d%d%lf",&s,&t,&c);
             s--; t--;
             // Dijkstra on N airports using edges AtoA[i][j] if <=c
-            static double distN[MAXN];
-            static int used[MAXN];
+            double *distN = arena.distN;
+            int *used = arena.used;
             for(int i=0;i<N;i++){
                 distN[i] = (i==s? 0.0: INF);
                 used[i]=0;
@@ -248,8 +300,9 @@ int main(){
                 }
                 if(u<0) break;
                 used[u]=1;
+                const double *Du = dist_row(D,Vn,u);
                 for(int v=0;v<N;v++){
-                    double w = AtoA[u][v];
+                    double w = Du[v];
                     if(w<=c+1e-9 && distN[u]+w < distN[v]){
                         distN[v] = distN[u]+w;
                     }
@@ -263,5 +316,6 @@ int main(){
         }
         fflush(stdout);
     }
+    arena_free(&arena);
     return 0;
 }
@@ -1,445 +1,1593 @@
 #include <iostream>
 #include <vector>
 #include <cmath>
-#include <iomanip>
 #include <limits>
 #include <algorithm>
-#include <map>
-#include <set> // Using set for automatic sorting and uniqueness based on custom comparator
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <unordered_map>
+#include <memory>
+#include <deque>
+#include <queue>
+#include <cstdint>
+#include <cstdio>
+#include <charconv>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
 
 using namespace std;
 
-const long double R_EARTH = 6370.0L;
-const long double EPS = 1e-9L;
-const long double INF = numeric_limits<long double>::infinity();
-const long double PI = 3.14159265358979323846L;
+// Geometry and graph code is templated on the scalar type T (float, double or long double)
+template <typename T> const T R_EARTH = T(6370.0L);
+template <typename T> const T EPS = T(1e-9L);
+template <typename T> const T INF = numeric_limits<T>::infinity();
+template <typename T> const T PI = T(3.14159265358979323846L);
 
+template <typename T>
 struct Point {
-    long double x, y, z;
-
-    // Custom comparator for set/map based on approximate equality
-    struct Compare {
-        bool operator()(const Point& a, const Point& b) const {
-            if (abs(a.x - b.x) > EPS) return a.x < b.x;
-            if (abs(a.y - b.y) > EPS) return a.y < b.y;
-            return a.z < b.z - EPS;
-        }
-    };
+    T x, y, z;
 };
 
 // Operators for Point
-Point operator+(const Point& a, const Point& b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
-Point operator-(const Point& a, const Point& b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
-Point operator*(const Point& a, long double s) { return {a.x * s, a.y * s, a.z * s}; }
-Point operator*(long double s, const Point& a) { return {a.x * s, a.y * s, a.z * s}; }
-Point operator/(const Point& a, long double s) { return {a.x / s, a.y / s, a.z / s}; }
+template <typename T> Point<T> operator+(const Point<T>& a, const Point<T>& b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+template <typename T> Point<T> operator-(const Point<T>& a, const Point<T>& b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+template <typename T> Point<T> operator*(const Point<T>& a, T s) { return {a.x * s, a.y * s, a.z * s}; }
+template <typename T> Point<T> operator*(T s, const Point<T>& a) { return {a.x * s, a.y * s, a.z * s}; }
+template <typename T> Point<T> operator/(const Point<T>& a, T s) { return {a.x / s, a.y / s, a.z / s}; }
 
 
 // Convert degrees lat/lon to 3D Cartesian coordinates on sphere
-Point lat_lon_to_xyz(long double lat_deg, long double lon_deg) {
-    long double lat_rad = lat_deg * PI / 180.0;
-    long double lon_rad = lon_deg * PI / 180.0;
-    long double x = R_EARTH * cos(lat_rad) * cos(lon_rad);
-    long double y = R_EARTH * cos(lat_rad) * sin(lon_rad);
-    long double z = R_EARTH * sin(lat_rad);
+template <typename T>
+Point<T> lat_lon_to_xyz(T lat_deg, T lon_deg) {
+    T lat_rad = lat_deg * PI<T> / 180;
+    T lon_rad = lon_deg * PI<T> / 180;
+    T x = R_EARTH<T> * cos(lat_rad) * cos(lon_rad);
+    T y = R_EARTH<T> * cos(lat_rad) * sin(lon_rad);
+    T z = R_EARTH<T> * sin(lat_rad);
     return {x, y, z};
 }
 
 // Dot product of two points (vectors)
-long double dot(const Point& p1, const Point& p2) {
+template <typename T>
+T dot(const Point<T>& p1, const Point<T>& p2) {
     return p1.x * p2.x + p1.y * p2.y + p1.z * p2.z;
 }
 
 // Cross product of two points (vectors)
-Point cross(const Point& p1, const Point& p2) {
+template <typename T>
+Point<T> cross(const Point<T>& p1, const Point<T>& p2) {
     return {p1.y * p2.z - p1.z * p2.y,
             p1.z * p2.x - p1.x * p2.z,
             p1.x * p2.y - p1.y * p2.x};
 }
 
 // Magnitude of a vector
-long double magnitude(const Point& p) {
+template <typename T>
+T magnitude(const Point<T>& p) {
     return sqrt(dot(p, p));
 }
 
 // Normalize a vector
-Point normalize(const Point& p) {
-    long double mag = magnitude(p);
-    if (mag < EPS) return {0, 0, 0};
+template <typename T>
+Point<T> normalize(const Point<T>& p) {
+    T mag = magnitude(p);
+    if (mag < EPS<T>) return {0, 0, 0};
     return p / mag;
 }
 
-// Great circle distance between two points on the sphere using XYZ coordinates
-long double dist_xyz(const Point& p1, const Point& p2) {
-    Point u1 = normalize(p1);
-    Point u2 = normalize(p2);
-    long double d = dot(u1, u2);
-    d = max((long double)-1.0, min((long double)1.0, d)); // Clamp
-    long double angle_rad = acos(d);
-    return angle_rad * R_EARTH;
-}
-
-// Get point on great circle through U and V at angular distance `angle_from_u` from U
-Point point_at_angle_on_great_circle(const Point& u, const Point& v, long double angle_from_u) {
-    Point u_norm = normalize(u);
-    Point v_norm = normalize(v);
-    long double angle_uv = acos(max((long double)-1.0, min((long double)1.0, dot(u_norm, v_norm))));
+// Get point on great circle through unit vectors U and V at angular distance `angle_from_u` from U
+template <typename T>
+Point<T> point_at_angle_on_great_circle(const Point<T>& u_norm, const Point<T>& v_norm, T angle_from_u) {
+    T angle_uv = acos(max((T)-1.0, min((T)1.0, dot(u_norm, v_norm))));
 
-    if (angle_uv < EPS) return u; // U and V are the same
+    if (angle_uv < EPS<T>) return u_norm; // U and V are the same
 
     // Create orthogonal basis in the great circle plane
-    Point v_ortho_norm = normalize(v_norm - u_norm * dot(u_norm, v_norm));
+    Point<T> v_ortho_norm = normalize(v_norm - u_norm * dot(u_norm, v_norm));
 
     // Point P on the great circle at angle angle_from_u from U
     return u_norm * cos(angle_from_u) + v_ortho_norm * sin(angle_from_u);
 }
 
 
-// Check if point P is on the great circle arc from U to V (inclusive)
-bool is_on_arc(const Point& u, const Point& v, const Point& p) {
-    long double dist_uv = dist_xyz(u, v);
-    long double dist_up = dist_xyz(u, p);
-    long double dist_pv = dist_xyz(p, v);
-    // Check if distance U-P + P-V equals distance U-V (within tolerance)
-    return abs(dist_up + dist_pv - dist_uv) < EPS;
-}
-
-// Get the parameter t in [0, 1] for a point P on the arc U-V based on distance
-long double get_arc_parameter(const Point& u, const Point& v, const Point& p) {
-    long double dist_uv = dist_xyz(u, v);
-    if (dist_uv < EPS) return 0.0; // U == V, any point is effectively parameter 0
-    long double dist_up = dist_xyz(u, p);
-    return dist_up / dist_uv;
-}
-
-
 // Find intersection points of two small circles on the Earth sphere with the same radius R_sphere
-vector<Point> get_small_circle_intersections(const Point& center1, const Point& center2, long double R_sphere) {
-    Point c1_norm = normalize(center1);
-    Point c2_norm = normalize(center2);
-    long double r_ang = R_sphere / R_EARTH;
-    long double d_ang = acos(max((long double)-1.0, min((long double)1.0, dot(c1_norm, c2_norm)))); // Angular distance between centers
-
-    vector<Point> intersections;
-
-    if (d_ang > 2 * r_ang + EPS) { // Spheres are too far apart
-        return intersections;
+// and append them to `intersections`. Centers are unit vectors; the intersections are R_EARTH-scaled
+template <typename T>
+void get_small_circle_intersections(const Point<T>& c1_norm, const Point<T>& c2_norm, T R_sphere, vector<Point<T>>& intersections) {
+    T r_ang = R_sphere / R_EARTH<T>;
+    T d_ang = acos(max((T)-1.0, min((T)1.0, dot(c1_norm, c2_norm)))); // Angular distance between centers
+
+    if (d_ang > 2 * r_ang + EPS<T>) { // Spheres are too far apart
+        return;
     }
-    if (d_ang < EPS) { // Centers are the same
-        return intersections; // Intersection is the circle itself, not useful graph vertices
+    if (d_ang < EPS<T>) { // Centers are the same
+        return; // Intersection is the circle itself, not useful graph vertices
     }
 
 
     // Angle beta from the midpoint M of C1-C2 arc to intersection point P along the equidistant great circle
     // cos(r_ang) = cos(d_ang/2) * cos(beta) => cos(beta) = cos(r_ang) / cos(d_ang/2)
-    long double cos_beta_arg = cos(r_ang) / cos(d_ang / 2.0);
-    if (cos_beta_arg > 1.0 + EPS || cos_beta_arg < -1.0 - EPS) {
+    T cos_beta_arg = cos(r_ang) / cos(d_ang / 2);
+    if (cos_beta_arg > 1 + EPS<T> || cos_beta_arg < -1 - EPS<T>) {
         // This might happen due to precision if d_ang is very close to 2*r_ang (tangent case)
         // Handle tangent case separately? For simplicity, clamp and continue.
-        cos_beta_arg = max((long double)-1.0, min((long double)1.0, cos_beta_arg));
+        cos_beta_arg = max((T)-1.0, min((T)1.0, cos_beta_arg));
     }
-    long double beta = acos(cos_beta_arg);
+    T beta = acos(cos_beta_arg);
 
     // Midpoint M of the C1-C2 arc (angularly)
-    Point m_norm = point_at_angle_on_great_circle(c1_norm, c2_norm, d_ang / 2.0);
+    Point<T> m_norm = point_at_angle_on_great_circle(c1_norm, c2_norm, d_ang / 2);
 
     // Vector orthogonal to m_norm in the plane of the equidistant great circle
     // The equidistant great circle plane is orthogonal to c1_norm - c2_norm
-    Point ortho_m_norm = normalize(cross(m_norm, c1_norm - c2_norm));
+    Point<T> ortho_m_norm = normalize(cross(m_norm, c1_norm - c2_norm));
 
     // The two intersection points are beta angular distance from M along the equidistant great circle
-    Point p1_norm = m_norm * cos(beta) + ortho_m_norm * sin(beta);
-    Point p2_norm = m_norm * cos(beta) - ortho_m_norm * sin(beta);
+    Point<T> p1_norm = m_norm * cos(beta) + ortho_m_norm * sin(beta);
+    Point<T> p2_norm = m_norm * cos(beta) - ortho_m_norm * sin(beta);
 
-    intersections.push_back({p1_norm.x * R_EARTH, p1_norm.y * R_EARTH, p1_norm.z * R_EARTH});
-    if (beta > EPS) { // Avoid adding duplicate point if tangent (beta=0)
-        intersections.push_back({p2_norm.x * R_EARTH, p2_norm.y * R_EARTH, p2_norm.z * R_EARTH});
+    intersections.push_back({p1_norm.x * R_EARTH<T>, p1_norm.y * R_EARTH<T>, p1_norm.z * R_EARTH<T>});
+    if (beta > EPS<T>) { // Avoid adding duplicate point if tangent (beta=0)
+        intersections.push_back({p2_norm.x * R_EARTH<T>, p2_norm.y * R_EARTH<T>, p2_norm.z * R_EARTH<T>});
     }
-
-    return intersections;
 }
 
 
-// Get parameters [t_start, t_end] on arc U-V (parameterized 0 to 1 by distance) that are inside R-sphere of center K
-vector<pair<long double, long double>> get_covered_intervals(const Point& u, const Point& v, const Point& k_center, long double R_sphere) {
-    long double r_ang = R_sphere / R_EARTH;
-    Point u_norm = normalize(u);
-    Point v_norm = normalize(v);
-    Point k_norm = normalize(k_center);
-    long double angle_uv = acos(max((long double)-1.0, min((long double)1.0, dot(u_norm, v_norm))));
-    if (angle_uv < EPS) { // U and V are the same or very close
-        // If U is inside R-sphere of K, the "arc" (point) is covered.
-        if (dist_xyz(u, k_center) <= R_sphere + EPS) return {{0.0, 1.0}};
-        else return {};
+// Snapping hash grid for vertex deduplication. Points within EPS of an existing vertex on every
+// axis reuse its id; cells are EPS wide, so a match can only sit in the 27 cells around the point.
+template <typename T>
+class VertexGrid {
+public:
+    // Id of `p`, appending it as a new vertex when no existing vertex is within EPS
+    int insert(const Point<T>& p) {
+        long long cx = cell_of(p.x), cy = cell_of(p.y), cz = cell_of(p.z);
+        for (long long dx = -1; dx <= 1; ++dx) {
+            for (long long dy = -1; dy <= 1; ++dy) {
+                for (long long dz = -1; dz <= 1; ++dz) {
+                    int id = find({cx + dx, cy + dy, cz + dz});
+                    if (id < 0) continue;
+                    const Point<T>& q = vertices[id];
+                    if (abs(p.x - q.x) <= EPS<T> && abs(p.y - q.y) <= EPS<T> && abs(p.z - q.z) <= EPS<T>) {
+                        return id;
+                    }
+                }
+            }
+        }
+        int id = vertices.size();
+        vertices.push_back(p);
+        *probe_free({cx, cy, cz}) = Slot{{cx, cy, cz}, id, generation};
+        return id;
     }
 
-    // Great circle through U and V has normal cross(u_norm, v_norm)
-    Point gc_normal = normalize(cross(u_norm, v_norm));
+    const vector<Point<T>>& points() const { return vertices; }
+
+    // Forget all vertices but keep the allocated storage for the next case. Bumping the
+    // generation empties every slot at once, so nothing is freed or rewritten here.
+    void reset(size_t expected_vertices) {
+        vertices.clear();
+        vertices.reserve(expected_vertices);
+        size_t want = 16;
+        while (want < 2 * expected_vertices) want *= 2; // Load factor stays <= 1/2
+        if (slots.size() < want || ++generation == 0) { // Grow, or wrap of the generation counter
+            slots.assign(max(want, slots.size()), Slot());
+            generation = 1;
+        }
+        mask = want - 1;
+    }
 
-    // Find points P on the great circle U-V where angle(P, K_norm) = r_ang
-    // This is intersection of great circle (dot(P, gc_normal)=0) and small circle (center K_norm, ang_rad r_ang)
-    // Project K_norm onto the plane of the great circle
-    Point k_proj_norm = k_norm - gc_normal * dot(k_norm, gc_normal);
-    k_proj_norm = normalize(k_proj_norm);
+private:
+    struct CellKey {
+        long long x, y, z;
+        bool operator==(const CellKey& o) const { return x == o.x && y == o.y && z == o.z; }
+    };
+    // Open-addressing entry; occupied only when `gen` matches the current generation
+    struct Slot {
+        CellKey key;
+        int id;
+        unsigned gen = 0;
+    };
 
-    long double d_k_to_plane_ang = acos(max((long double)-1.0, min((long double)1.0, abs(dot(k_norm, gc_normal)))));
+    vector<Point<T>> vertices;
+    vector<Slot> slots;
+    size_t mask = 0;
+    unsigned generation = 0;
 
-    vector<long double> critical_params;
-    critical_params.push_back(0.0); // Arc start
-    critical_params.push_back(1.0); // Arc end
+    static size_t hash(const CellKey& k) {
+        // Unsigned arithmetic: cell coordinates reach ~6.4e12, so signed products would overflow
+        return (size_t)((uint64_t)k.x * 73856093u ^ (uint64_t)k.y * 19349663u ^ (uint64_t)k.z * 83492791u);
+    }
 
-    if (d_k_to_plane_ang <= r_ang + EPS) { // Small circle boundary intersects or is tangent to or contains the great circle
-        long double alpha; // Angle on the great circle from k_proj_norm to intersection points
-        if (abs(d_k_to_plane_ang - r_ang) < EPS) {
-             alpha = 0; // Tangent case
-        } else {
-            // cos(r_ang) = cos(d_k_to_plane_ang) * cos(alpha)
-            long double cos_alpha_arg = cos(r_ang) / cos(d_k_to_plane_ang);
-            if (cos_alpha_arg >= -1.0 - EPS && cos_alpha_arg <= 1.0 + EPS) {
-                alpha = acos(max((long double)-1.0, min((long double)1.0, cos_alpha_arg)));
+    // Id stored for cell `k`, or -1; linear probing until the first empty slot
+    int find(const CellKey& k) const {
+        for (size_t i = hash(k) & mask;; i = (i + 1) & mask) {
+            const Slot& slot = slots[i];
+            if (slot.gen != generation) return -1;
+            if (slot.key == k) return slot.id;
+        }
+    }
 
-                // Vector in great circle plane orthogonal to k_proj_norm
-                Point ortho_k_proj_norm = normalize(cross(gc_normal, k_proj_norm));
+    // First empty slot on the probe sequence of `k` (a cell holds at most one vertex)
+    Slot* probe_free(const CellKey& k) {
+        size_t i = hash(k) & mask;
+        while (slots[i].gen == generation) i = (i + 1) & mask;
+        return &slots[i];
+    }
 
-                // The two intersection points on the great circle
-                Point p1_norm_gc = k_proj_norm * cos(alpha) + ortho_k_proj_norm * sin(alpha);
-                Point p2_norm_gc = k_proj_norm * cos(alpha) - ortho_k_proj_norm * sin(alpha);
+    static long long cell_of(T coord) { return (long long)floor(coord / EPS<T>); }
+};
 
-                Point p1_gc = {p1_norm_gc.x * R_EARTH, p1_norm_gc.y * R_EARTH, p1_norm_gc.z * R_EARTH};
-                Point p2_gc = {p2_norm_gc.x * R_EARTH, p2_norm_gc.y * R_EARTH, p2_norm_gc.z * R_EARTH};
+// Build the compact vertex table of a case in `grid`: airports first (their ids go to
+// airport_to_vertex_idx as they are inserted), then the distinct cap-boundary intersections.
+// unit_airports holds the same airports already normalized
+template <typename T>
+void build_vertices(const vector<Point<T>>& airports, const vector<Point<T>>& unit_airports, T R,
+                    VertexGrid<T>& grid, vector<int>& airport_to_vertex_idx) {
+    int n = airports.size();
+    grid.reset(n + (size_t)n * (n - 1)); // At most two intersections per airport pair
+    airport_to_vertex_idx.resize(n);
+    for (int i = 0; i < n; ++i) airport_to_vertex_idx[i] = grid.insert(airports[i]);
+
+    vector<Point<T>> intersections;
+    for (int i = 0; i < n; ++i) {
+        for (int j = i + 1; j < n; ++j) {
+            intersections.clear();
+            get_small_circle_intersections(unit_airports[i], unit_airports[j], R, intersections);
+            for (const auto& p : intersections) grid.insert(p);
+        }
+    }
+}
 
+// Orthonormal frame of the great circle through unit vectors U and V:
+// P(phi) = cos(phi) * u + sin(phi) * w walks the arc U-V for phi in [0, theta]; v is P(theta)
+// and mid is P(theta / 2)
+template <typename T>
+struct ArcBasis {
+    Point<T> u, w, v, mid;
+    T theta;
+};
 
-                // Check if these points lie on the arc U-V and add their parameters
-                if (is_on_arc(u, v, p1_gc)) {
-                     critical_params.push_back(get_arc_parameter(u, v, p1_gc));
-                }
-                if (alpha > EPS && is_on_arc(u, v, p2_gc)) { // Avoid adding duplicate point if tangent
-                     critical_params.push_back(get_arc_parameter(u, v, p2_gc));
-                }
-            } else {
-                // No intersection between the great circle and the small circle boundary.
-                // The arc is either entirely inside or entirely outside the R-sphere of K.
-                // Check the midpoint of the arc.
-                long double mid_t_angle = angle_uv / 2.0;
-                Point p_mid = point_at_angle_on_great_circle(u, v, mid_t_angle);
-                if (dist_xyz(p_mid, k_center) <= R_sphere + EPS) {
-                    // Entire arc is inside this R-sphere
-                    return {{0.0, 1.0}};
-                } else {
-                    // Entire arc is outside this R-sphere
-                    return {};
-                }
-            }
-        }
+// Build the frame from unit vectors and their (clamped) cosine
+template <typename T>
+ArcBasis<T> make_arc_basis(const Point<T>& u_norm, const Point<T>& v_norm, T c) {
+    ArcBasis<T> arc;
+    arc.u = u_norm;
+    arc.v = v_norm;
+    arc.theta = acos(c);
+    arc.w = v_norm - u_norm * c;
+    T w_len = magnitude(arc.w);
+    if (w_len < EPS<T>) {
+        // U and V coincide or are antipodal: the plane is undetermined, take any direction orthogonal to U
+        Point<T> axis = abs(u_norm.x) < T(0.5) ? Point<T>{1, 0, 0} : Point<T>{0, 1, 0};
+        arc.w = normalize(cross(u_norm, axis));
     } else {
-        // No intersection between great circle and small circle boundary.
-        // Arc is either entirely inside or entirely outside. Check midpoint.
-        long double mid_t_angle = angle_uv / 2.0;
-        Point p_mid = point_at_angle_on_great_circle(u, v, mid_t_angle);
-        if (dist_xyz(p_mid, k_center) <= R_sphere + EPS) {
-            return {{0.0, 1.0}};
-        } else {
-            return {};
+        arc.w = arc.w / w_len;
+    }
+    // |U + V| = sqrt(2 + 2 cos theta); the sum vanishes for antipodal endpoints
+    T mid_len = sqrt(max((T)0.0, 2 + 2 * c));
+    arc.mid = mid_len < EPS<T> ? arc.w : (u_norm + v_norm) / mid_len;
+    return arc;
+}
+
+// Append the parameters [t_start, t_end] on the arc (parameterized 0 to 1 by distance) that are inside
+// the cap around unit vector K with cos(angular radius) = cos_r. Closed form: with du = K.u and
+// dw = K.w, dot(P(phi), K) = rho * cos(phi - psi) where rho = |(du, dw)| and psi = atan2(dw, du).
+template <typename T>
+void get_covered_intervals(const ArcBasis<T>& arc, const Point<T>& k_norm, T cos_r, vector<pair<T, T>>& intervals) {
+    T du = dot(arc.u, k_norm);
+    T dw = dot(arc.w, k_norm);
+    T rho = sqrt(du * du + dw * dw);
+
+    if (rho <= cos_r) return;                 // The great circle never enters the cap
+    if (rho <= -cos_r) {                      // Cap wider than a hemisphere contains the whole circle
+        intervals.push_back({0, 1});
+        return;
+    }
+
+    T psi = atan2(dw, du);
+    T delta = acos(cos_r / rho);    // Half-width of the covered range around psi
+
+    for (T shift : {-2 * PI<T>, (T)0.0, 2 * PI<T>}) {
+        T lo = max((T)0.0, psi - delta + shift);
+        T hi = min(arc.theta, psi + delta + shift);
+        if (hi > lo) intervals.push_back({lo / arc.theta, hi / arc.theta});
+    }
+}
+
+
+// Up to this many intervals, coverage is checked by repeated scans instead of sorting
+const size_t SMALL_INTERVAL_COUNT = 8;
+
+// Greedy coverage check of [0, 1], tolerating EPS gaps. Returns false at the first gap and true as
+// soon as the covered prefix reaches 1. Few intervals: rescan the unsorted list, each pass jumping
+// to the furthest end among intervals that start within reach (O(k^2) but no sort). Otherwise sort
+// by start and sweep once. Both accept exactly the arcs a full merge-then-scan would.
+template <typename T>
+bool intervals_cover_unit(vector<pair<T, T>>& intervals) {
+    T reach = 0;
+    if (intervals.size() <= SMALL_INTERVAL_COUNT) {
+        while (true) {
+            T best = reach;
+            for (const auto& interval : intervals) {
+                if (interval.first <= reach + EPS<T> && interval.second > best) best = interval.second;
+            }
+            if (best >= 1 - EPS<T>) return true;
+            if (best == reach) return false; // Gap: nothing extends the covered prefix
+            reach = best;
         }
     }
 
+    sort(intervals.begin(), intervals.end());
+    for (const auto& interval : intervals) {
+        if (interval.first > reach + EPS<T>) return false; // Gap
+        reach = max(reach, interval.second);
+        if (reach >= 1 - EPS<T>) return true;
+    }
+    return false;
+}
 
-    sort(critical_params.begin(), critical_params.end());
-    critical_params.erase(unique(critical_params.begin(), critical_params.end(), [](long double a, long double b){ return abs(a-b) < EPS; }), critical_params.end());
+// Extra angular slack (radians) for spatial index queries so EPS-level touches are never pruned
+template <typename T> const T INDEX_MARGIN = T(1e-6L);
+
+// Airport unit vectors as separate x/y/z arrays of doubles, so one arc can be tested against
+// several airports per vector instruction. `id` maps a slot back to the airport index.
+struct AirportSoA {
+    vector<double> x, y, z;
+    vector<int> id;
+
+    template <typename T>
+    void push_back(const Point<T>& p, int airport) {
+        x.push_back((double)p.x);
+        y.push_back((double)p.y);
+        z.push_back((double)p.z);
+        id.push_back(airport);
+    }
+};
 
-    vector<pair<long double, long double>> intervals;
-    for(size_t i = 0; i + 1 < critical_params.size(); ++i) {
-        long double t_start = critical_params[i];
-        long double t_end = critical_params[i+1];
-        if (t_end - t_start < EPS) continue;
+// Per-arc constants for the batched airport filter. An airport K passes when it lies within the
+// reach of the arc midpoint (K.mid >= cos_reach) and its cap meets the arc's great circle
+// (du^2 + dw^2 > rho_min_sq). Both tests carry slack so double rounding never rejects an airport
+// that the exact interval solve in T would accept.
+struct ArcFilter {
+    double ux, uy, uz, wx, wy, wz, mx, my, mz;
+    double cos_reach, rho_min_sq;
+
+    template <typename T>
+    ArcFilter(const ArcBasis<T>& arc, T reach, T cos_r) {
+        ux = arc.u.x; uy = arc.u.y; uz = arc.u.z;
+        wx = arc.w.x; wy = arc.w.y; wz = arc.w.z;
+        mx = arc.mid.x; my = arc.mid.y; mz = arc.mid.z;
+        // Rounding in T can be much coarser than in double (float), so the slack scales with it
+        double slack = max(1e-9, 256.0 * (double)numeric_limits<T>::epsilon());
+        cos_reach = reach >= PI<T> ? -2.0 : (double)cos(reach) - slack;
+        // rho <= cos_r means no coverage; with cos_r <= 0 every airport may cover something
+        rho_min_sq = cos_r > 0 ? (double)(cos_r * cos_r) - slack : -1.0;
+    }
+};
 
-        long double t_mid = (t_start + t_end) / 2.0;
-        // Get the point on the arc at t_mid parameter (based on distance parameter)
-        Point p_mid = point_at_angle_on_great_circle(u, v, t_mid * angle_uv);
+// Append the ids of airports in slots [begin, end) that pass `f`
+void filter_airports_scalar(const ArcFilter& f, const AirportSoA& soa, int begin, int end, vector<int>& out) {
+    for (int k = begin; k < end; ++k) {
+        double dm = soa.x[k] * f.mx + soa.y[k] * f.my + soa.z[k] * f.mz;
+        double du = soa.x[k] * f.ux + soa.y[k] * f.uy + soa.z[k] * f.uz;
+        double dw = soa.x[k] * f.wx + soa.y[k] * f.wy + soa.z[k] * f.wz;
+        if (dm >= f.cos_reach && du * du + dw * dw > f.rho_min_sq) out.push_back(soa.id[k]);
+    }
+}
 
-        // Check if the midpoint is inside the R-sphere of K
-        if (dist_xyz(p_mid, k_center) <= R_sphere + EPS) {
-            intervals.push_back({t_start, t_end});
+#ifdef HAVE_X86_SIMD
+// Four airports per iteration
+__attribute__((target("avx2,fma")))
+void filter_airports_avx2(const ArcFilter& f, const AirportSoA& soa, int begin, int end, vector<int>& out) {
+    const __m256d ux = _mm256_set1_pd(f.ux), uy = _mm256_set1_pd(f.uy), uz = _mm256_set1_pd(f.uz);
+    const __m256d wx = _mm256_set1_pd(f.wx), wy = _mm256_set1_pd(f.wy), wz = _mm256_set1_pd(f.wz);
+    const __m256d mx = _mm256_set1_pd(f.mx), my = _mm256_set1_pd(f.my), mz = _mm256_set1_pd(f.mz);
+    const __m256d cos_reach = _mm256_set1_pd(f.cos_reach), rho_min_sq = _mm256_set1_pd(f.rho_min_sq);
+    int k = begin;
+    for (; k + 4 <= end; k += 4) {
+        __m256d x = _mm256_loadu_pd(&soa.x[k]), y = _mm256_loadu_pd(&soa.y[k]), z = _mm256_loadu_pd(&soa.z[k]);
+        __m256d dm = _mm256_fmadd_pd(z, mz, _mm256_fmadd_pd(y, my, _mm256_mul_pd(x, mx)));
+        __m256d du = _mm256_fmadd_pd(z, uz, _mm256_fmadd_pd(y, uy, _mm256_mul_pd(x, ux)));
+        __m256d dw = _mm256_fmadd_pd(z, wz, _mm256_fmadd_pd(y, wy, _mm256_mul_pd(x, wx)));
+        __m256d rho_sq = _mm256_fmadd_pd(dw, dw, _mm256_mul_pd(du, du));
+        __m256d pass = _mm256_and_pd(_mm256_cmp_pd(dm, cos_reach, _CMP_GE_OQ),
+                                     _mm256_cmp_pd(rho_sq, rho_min_sq, _CMP_GT_OQ));
+        for (int bits = _mm256_movemask_pd(pass); bits; bits &= bits - 1) {
+            out.push_back(soa.id[k + __builtin_ctz(bits)]);
         }
     }
+    filter_airports_scalar(f, soa, k, end, out);
+}
 
-    return intervals;
+// Eight airports per iteration
+__attribute__((target("avx512f")))
+void filter_airports_avx512(const ArcFilter& f, const AirportSoA& soa, int begin, int end, vector<int>& out) {
+    const __m512d ux = _mm512_set1_pd(f.ux), uy = _mm512_set1_pd(f.uy), uz = _mm512_set1_pd(f.uz);
+    const __m512d wx = _mm512_set1_pd(f.wx), wy = _mm512_set1_pd(f.wy), wz = _mm512_set1_pd(f.wz);
+    const __m512d mx = _mm512_set1_pd(f.mx), my = _mm512_set1_pd(f.my), mz = _mm512_set1_pd(f.mz);
+    const __m512d cos_reach = _mm512_set1_pd(f.cos_reach), rho_min_sq = _mm512_set1_pd(f.rho_min_sq);
+    int k = begin;
+    for (; k + 8 <= end; k += 8) {
+        __m512d x = _mm512_loadu_pd(&soa.x[k]), y = _mm512_loadu_pd(&soa.y[k]), z = _mm512_loadu_pd(&soa.z[k]);
+        __m512d dm = _mm512_fmadd_pd(z, mz, _mm512_fmadd_pd(y, my, _mm512_mul_pd(x, mx)));
+        __m512d du = _mm512_fmadd_pd(z, uz, _mm512_fmadd_pd(y, uy, _mm512_mul_pd(x, ux)));
+        __m512d dw = _mm512_fmadd_pd(z, wz, _mm512_fmadd_pd(y, wy, _mm512_mul_pd(x, wx)));
+        __m512d rho_sq = _mm512_fmadd_pd(dw, dw, _mm512_mul_pd(du, du));
+        __mmask8 pass = _mm512_cmp_pd_mask(dm, cos_reach, _CMP_GE_OQ) &
+                        _mm512_cmp_pd_mask(rho_sq, rho_min_sq, _CMP_GT_OQ);
+        for (unsigned bits = pass; bits; bits &= bits - 1) {
+            out.push_back(soa.id[k + __builtin_ctz(bits)]);
+        }
+    }
+    filter_airports_scalar(f, soa, k, end, out);
+}
+#endif
+
+typedef void (*AirportFilterFn)(const ArcFilter&, const AirportSoA&, int, int, vector<int>&);
+
+// Pick the widest kernel the running CPU supports
+AirportFilterFn select_airport_filter() {
+#ifdef HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return filter_airports_avx512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return filter_airports_avx2;
+#endif
+    return filter_airports_scalar;
 }
 
+const AirportFilterFn filter_airports = select_airport_filter();
+
+// Cube-map cell grid over airport unit vectors. Each occupied cell keeps a bounding cap
+// (center + angular radius) and a contiguous slot range in the SoA layout, so a query only
+// runs the batched filter over airports in cells near the arc.
+template <typename T>
+class AirportIndex {
+public:
+    AirportIndex(const vector<Point<T>>& unit_airports) {
+        int n = unit_airports.size();
+        grid = max(1, (int)ceil(sqrt(n / 24.0))); // ~4 airports per occupied cell
+
+        // Group airports by cell so each cell owns a contiguous run of SoA slots
+        vector<pair<int, int>> keyed(n);
+        for (int k = 0; k < n; ++k) {
+            int face, ci, cj;
+            locate(unit_airports[k], face, ci, cj);
+            keyed[k] = {(face * grid + ci) * grid + cj, k};
+        }
+        sort(keyed.begin(), keyed.end());
 
-// Merge overlapping intervals [t_start, t_end]
-vector<pair<long double, long double>> merge_intervals(vector<pair<long double, long double>>& intervals) {
-    if (intervals.empty()) return {};
-    sort(intervals.begin(), intervals.end());
-    vector<pair<long double, long double>> merged;
-    if (!intervals.empty()) {
-        merged.push_back(intervals[0]);
-        for (size_t i = 1; i < intervals.size(); ++i) {
-            if (intervals[i].first <= merged.back().second + EPS) { // Overlap or touch
-                merged.back().second = max(merged.back().second, intervals[i].second);
-            } else {
-                merged.push_back(intervals[i]);
+        for (int slot = 0; slot < n; ++slot) {
+            int key = keyed[slot].first;
+            if (slot == 0 || key != keyed[slot - 1].first) {
+                cells.push_back(make_cell(key / (grid * grid), key / grid % grid, key % grid));
+                cells.back().begin = slot;
             }
+            cells.back().end = slot + 1;
+            soa.push_back(unit_airports[keyed[slot].second], keyed[slot].second);
         }
     }
-    return merged;
-}
 
-// Check if arc U-V is safe (fully covered by union of R-spheres of airports)
-bool is_arc_safe(const Point& u, const Point& v, const vector<Point>& airports, long double R_sphere) {
-    long double dist_uv = dist_xyz(u, v);
-    if (dist_uv < EPS) return true; // Zero-length arc is always safe
+    // Append to `out` every airport within angle `reach` of the arc midpoint whose cap
+    // (cos of angular radius = cos_r) meets the arc's great circle
+    void query(const ArcBasis<T>& arc, T reach, T cos_r, vector<int>& out) const {
+        ArcFilter filter(arc, reach, cos_r);
+        T cos_q = cos(reach), sin_q = sin(reach);
+        for (const auto& cell : cells) {
+            // angle(mid, cell) <= reach + cell.radius, via cos(a + b) = cos a cos b - sin a sin b
+            if (reach + cell.radius < PI<T> &&
+                dot(arc.mid, cell.center) < cos_q * cell.cos_radius - sin_q * cell.sin_radius) continue;
+            filter_airports(filter, soa, cell.begin, cell.end, out);
+        }
+    }
 
-    vector<pair<long double, long double>> all_intervals;
-    for (const auto& airport_loc : airports) {
-        vector<pair<long double, long double>> intervals = get_covered_intervals(u, v, airport_loc, R_sphere);
-        all_intervals.insert(all_intervals.end(), intervals.begin(), intervals.end());
+private:
+    struct Cell {
+        Point<T> center;
+        T radius, cos_radius, sin_radius;
+        int begin, end; // Slot range in soa
+    };
+
+    int grid;
+    vector<Cell> cells;
+    AirportSoA soa;
+
+    // Point on cube face `face` (axis * 2 + sign) at face coordinates (a, b) in [-1, 1], as a unit vector
+    static Point<T> face_point(int face, T a, T b) {
+        T sign = (face % 2 == 0) ? 1 : -1;
+        switch (face / 2) {
+            case 0: return normalize(Point<T>{sign, a, b});
+            case 1: return normalize(Point<T>{a, sign, b});
+            default: return normalize(Point<T>{a, b, sign});
+        }
     }
 
-    vector<pair<long double, long double>> merged = merge_intervals(all_intervals);
+    void locate(const Point<T>& p, int& face, int& ci, int& cj) const {
+        T ax = abs(p.x), ay = abs(p.y), az = abs(p.z);
+        T a, b, m;
+        if (ax >= ay && ax >= az) { face = p.x >= 0 ? 0 : 1; a = p.y; b = p.z; m = ax; }
+        else if (ay >= az)        { face = p.y >= 0 ? 2 : 3; a = p.x; b = p.z; m = ay; }
+        else                      { face = p.z >= 0 ? 4 : 5; a = p.x; b = p.y; m = az; }
+        ci = min(grid - 1, max(0, (int)((a / m + 1) / 2 * grid)));
+        cj = min(grid - 1, max(0, (int)((b / m + 1) / 2 * grid)));
+    }
 
-    // Check if the interval [0, 1] is fully covered
-    if (merged.empty()) return false;
+    Cell make_cell(int face, int ci, int cj) const {
+        T a0 = T(2) * ci / grid - 1, a1 = T(2) * (ci + 1) / grid - 1;
+        T b0 = T(2) * cj / grid - 1, b1 = T(2) * (cj + 1) / grid - 1;
+        Cell cell;
+        cell.center = face_point(face, (a0 + a1) / 2, (b0 + b1) / 2);
+        // Cells are convex spherical quads, so the farthest point from the center is a corner
+        T min_cos = 1;
+        for (T a : {a0, a1}) {
+            for (T b : {b0, b1}) min_cos = min(min_cos, dot(cell.center, face_point(face, a, b)));
+        }
+        cell.radius = acos(max((T)-1.0, min_cos)) + INDEX_MARGIN<T>;
+        cell.cos_radius = cos(cell.radius);
+        cell.sin_radius = sin(cell.radius);
+        return cell;
+    }
+};
 
-    long double current_t = 0.0;
-    for(const auto& interval : merged) {
-        if (interval.first > current_t + EPS) return false; // Gap
-        current_t = max(current_t, interval.second);
+// Cheap sufficient tests for "this arc is not covered", run before the full interval merge:
+//  - length bound: a cap of angular radius r <= pi/2 meets a great circle in at most 2r, so k
+//    candidate caps cover at most 2kr of the arc (plus the EPS gaps the sweep tolerates);
+//  - probes: a point at 1/2, 1/4 or 3/4 of the arc that is farther than r + margin from every
+//    candidate sits in a gap at least 2 * margin wide, which the sweep would reject too.
+template <typename T>
+bool arc_rejected_early(const ArcBasis<T>& arc, const vector<int>& candidates, const vector<Point<T>>& unit_airports, T r_ang) {
+    size_t k = candidates.size();
+    if (r_ang <= PI<T> / 2 && k * 2 * r_ang + (k + 1) * EPS<T> * arc.theta < arc.theta) return true;
+
+    T margin = max(T(1e-7L), 64 * numeric_limits<T>::epsilon());
+    if (r_ang + margin >= PI<T>) return false;
+    T cos_probe = cos(r_ang + margin);
+    // Midpoint, then the quarter points as normalized sums of neighbouring probes (no trig needed)
+    Point<T> probes[3] = {arc.mid, normalize(arc.u + arc.mid), normalize(arc.mid + arc.v)};
+    for (const Point<T>& probe : probes) {
+        bool near_cap = false;
+        for (int c : candidates) {
+            if (dot(probe, unit_airports[c]) >= cos_probe) { near_cap = true; break; }
+        }
+        if (!near_cap) return true;
     }
-    if (current_t < 1.0 - EPS) return false; // Does not reach the end
+    return false;
+}
 
-    return true;
+// Per-thread buffers reused by every is_arc_safe call, so the hot loop never allocates
+template <typename T>
+struct ArcScratch {
+    vector<int> candidates;
+    vector<pair<T, T>> intervals;
+};
+
+// Check if the arc is safe (fully covered by union of R-spheres of airports, given as unit vectors)
+template <typename T>
+bool is_arc_safe(const ArcBasis<T>& arc, const vector<Point<T>>& unit_airports, const AirportIndex<T>& index, T R_sphere,
+                 ArcScratch<T>& scratch) {
+    if (arc.theta * R_EARTH<T> < EPS<T>) return true; // Zero-length arc is always safe
+
+    // The arc lies within theta / 2 of its midpoint; only caps reaching that disk can cover it
+    T reach = arc.theta / 2 + R_sphere / R_EARTH<T> + INDEX_MARGIN<T>;
+    if (PI<T> - arc.theta < EPS<T>) reach = PI<T>; // Antipodal endpoints: the arc plane is arbitrary, keep everything
+    // A point is inside a cap when its distance to the center is <= R (+ EPS km)
+    T r_ang = (R_sphere + EPS<T>) / R_EARTH<T>;
+    T cos_r = cos(r_ang);
+    vector<int>& candidates = scratch.candidates;
+    candidates.clear();
+    index.query(arc, reach, cos_r, candidates);
+    if (arc_rejected_early(arc, candidates, unit_airports, r_ang)) return false;
+
+    vector<pair<T, T>>& intervals = scratch.intervals;
+    intervals.clear();
+    for (int k : candidates) get_covered_intervals(arc, unit_airports[k], cos_r, intervals);
+
+    // Check if the interval [0, 1] is fully covered
+    return intervals_cover_unit(intervals);
 }
 
-int main() {
-    ios_base::sync_with_stdio(false);
-    cin.tie(NULL);
+// Dense V x V distance matrix stored contiguously in row-major order
+template <typename T>
+struct DistMatrix {
+    int n;
+    vector<T> d;
+
+    DistMatrix(int n = 0) : n(n), d((size_t)n * n, INF<T>) {}
 
-    cout << fixed << setprecision(3);
+    T* operator[](int i) { return &d[(size_t)i * n]; }
+    const T* operator[](int i) const { return &d[(size_t)i * n]; }
+};
 
-    int N, Q, case_num = 1;
-    long double R;
+// Points normalized once onto the unit sphere; the hot loops use these instead of the
+// R_EARTH-scaled originals so no known point is ever re-normalized
+template <typename T>
+struct UnitStore {
+    vector<Point<T>> unit;
 
-    while (cin >> N >> R) {
-        vector<Point> airports_xyz(N);
-        for (int i = 0; i < N; ++i) {
-            long double lat, lon;
-            cin >> lon >> lat; // Input is lon lat
-            airports_xyz[i] = lat_lon_to_xyz(lat, lon);
+    explicit UnitStore(const vector<Point<T>>& points) {
+        unit.reserve(points.size());
+        for (const auto& p : points) unit.push_back(normalize(p));
+    }
+
+    int size() const { return unit.size(); }
+    const Point<T>& operator[](int i) const { return unit[i]; }
+
+    // Cosine of the angle between points i and j, clamped to [-1, 1]
+    T cos_between(int i, int j) const {
+        return max((T)-1.0, min((T)1.0, dot(unit[i], unit[j])));
+    }
+
+    // Table of cos_between for every pair, built on first call; the solver itself does not use it
+    const DistMatrix<T>& pairwise_cosines() {
+        if (cosines.n != size()) {
+            int n = size();
+            cosines = DistMatrix<T>(n);
+            for (int i = 0; i < n; ++i) {
+                for (int j = i; j < n; ++j) cosines[i][j] = cosines[j][i] = cos_between(i, j);
+            }
         }
+        return cosines;
+    }
+
+private:
+    DistMatrix<T> cosines;
+};
 
-        set<Point, Point::Compare> unique_vertices_set;
-        for(const auto& p : airports_xyz) unique_vertices_set.insert(p);
+// Decides whether the arc between two vertices of a case is safe, given the case geometry
+template <typename T>
+struct SafeArcTester {
+    const UnitStore<T>& vertices;
+    const vector<Point<T>>& unit_airports;
+    const AirportIndex<T>& index;
+    T R;
+
+    // Cosine of the angle between vertices i and j. Computed per pair: each one is read only once
+    // or twice, so a V x V table would double the matrix memory of a case for nothing.
+    T cos_between(int i, int j) const { return vertices.cos_between(i, j); }
+
+    // Length (km) of the arc between vertices i and j, or INF if it is not safe
+    T safe_length(int i, int j, ArcScratch<T>& scratch) const {
+        if (i > j) swap(i, j); // Same frame orientation whichever end asks
+        ArcBasis<T> arc = make_arc_basis(vertices[i], vertices[j], cos_between(i, j));
+        T d_ij = arc.theta * R_EARTH<T>;
+        // Optimization: if endpoints are identical, arc safety is trivial. Antipodal endpoints
+        // go through the general test with an arbitrary great circle between them.
+        bool safe = d_ij < EPS<T> || is_arc_safe(arc, unit_airports, index, R, scratch);
+        return safe ? d_ij : INF<T>;
+    }
+};
 
-        // Add intersection points of R-spheres as vertices
-        for (int i = 0; i < N; ++i) {
-            for (int j = i + 1; j < N; ++j) {
-                vector<Point> intersections = get_small_circle_intersections(airports_xyz[i], airports_xyz[j], R);
-                for (const auto& p : intersections) {
-                   unique_vertices_set.insert(p);
-                }
+// Auxiliary graph whose arcs are tested for safety only when a search first tries to relax them.
+// Arc lengths are tabulated up front (one acos per pair); the safety verdict is memoized per pair.
+// The memo is atomic so several searches can share it from different threads. Lengths are stored as D.
+template <typename T, typename D = T>
+class LazyArcGraph {
+public:
+    explicit LazyArcGraph(const SafeArcTester<T>& tester)
+        : tester(tester), n(tester.vertices.size()), lengths(n), memo(new atomic<unsigned char>[(size_t)n * n]) {
+        for (int i = 0; i < n; ++i) {
+            for (int j = i; j < n; ++j) {
+                lengths[i][j] = lengths[j][i] = acos(tester.cos_between(i, j)) * R_EARTH<T>;
             }
         }
+        for (size_t k = 0; k < (size_t)n * n; ++k) memo[k].store(UNKNOWN, memory_order_relaxed);
+    }
 
-        vector<Point> vertices(unique_vertices_set.begin(), unique_vertices_set.end());
-        map<Point, int, Point::Compare> vertex_map;
-        vector<int> airport_to_vertex_idx(N);
+    int size() const { return n; }
 
-        for (int i = 0; i < vertices.size(); ++i) {
-            vertex_map[vertices[i]] = i;
+    // Great-circle length of the arc i-j, safe or not
+    D length(int i, int j) const { return lengths[i][j]; }
+
+    bool safe(int i, int j, ArcScratch<T>& scratch) {
+        if (i > j) swap(i, j);
+        atomic<unsigned char>& slot = memo[(size_t)i * n + j];
+        unsigned char state = slot.load(memory_order_relaxed);
+        if (state == UNKNOWN) {
+            state = tester.safe_length(i, j, scratch) != INF<T> ? SAFE : UNSAFE;
+            slot.store(state, memory_order_relaxed);
         }
-        for (int i = 0; i < N; ++i) {
-             airport_to_vertex_idx[i] = vertex_map[airports_xyz[i]];
+        return state == SAFE;
+    }
+
+private:
+    enum : unsigned char { UNKNOWN, SAFE, UNSAFE };
+
+    const SafeArcTester<T>& tester;
+    int n;
+    DistMatrix<D> lengths;
+    unique_ptr<atomic<unsigned char>[]> memo;
+};
+
+// Tile edge for the blocked Floyd-Warshall; 32x32 tile (16 KB of long double)
+const int FW_BLOCK = 32;
+
+// Relax tile (ib, jb) through every k of tile kb: d[i][j] = min(d[i][j], d[i][k] + d[k][j])
+template <typename T>
+void fw_relax_tile(DistMatrix<T>& dist, int ib, int jb, int kb) {
+    int n = dist.n;
+    int i_end = min(ib + FW_BLOCK, n), j_end = min(jb + FW_BLOCK, n), k_end = min(kb + FW_BLOCK, n);
+    for (int k = kb; k < k_end; ++k) {
+        const T* row_k = dist[k];
+        for (int i = ib; i < i_end; ++i) {
+            T* row_i = dist[i];
+            T d_ik = row_i[k];
+            if (d_ik == INF<T>) continue;
+            for (int j = jb; j < j_end; ++j) {
+                T via = d_ik + row_k[j];
+                if (via < row_i[j]) row_i[j] = via;
+            }
         }
+    }
+}
 
+// Fixed set of worker threads that split an index range [0, count) between themselves
+// and the calling thread. Tasks are handed out dynamically via an atomic counter.
+class ThreadPool {
+public:
+    explicit ThreadPool(int threads) {
+        for (int i = 1; i < threads; ++i) workers.emplace_back([this] { worker_loop(); });
+    }
 
-        int V = vertices.size();
-        vector<vector<long double>> adj_aux(V, vector<long double>(V, INF));
+    ~ThreadPool() {
+        {
+            lock_guard<mutex> lock(mtx);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& w : workers) w.join();
+    }
 
-        for (int i = 0; i < V; ++i) {
+    int size() const { return (int)workers.size() + 1; }
+
+    // Run fn(task) for every task in [0, count); returns once all tasks have finished
+    void parallel_for(int count, const function<void(int)>& fn) {
+        if (workers.empty() || count <= 1) {
+            for (int task = 0; task < count; ++task) fn(task);
+            return;
+        }
+        {
+            lock_guard<mutex> lock(mtx);
+            job = &fn;
+            job_count = count;
+            next_task = 0;
+            busy = (int)workers.size();
+            ++generation;
+        }
+        wake.notify_all();
+        run_tasks(fn, count);
+
+        unique_lock<mutex> lock(mtx);
+        done.wait(lock, [this] { return busy == 0; });
+        job = nullptr;
+    }
+
+private:
+    vector<thread> workers;
+    mutex mtx;
+    condition_variable wake, done;
+    const function<void(int)>* job = nullptr;
+    int job_count = 0;
+    atomic<int> next_task{0};
+    int busy = 0;
+    long long generation = 0;
+    bool stopping = false;
+
+    void run_tasks(const function<void(int)>& fn, int count) {
+        for (int task; (task = next_task.fetch_add(1)) < count; ) fn(task);
+    }
+
+    void worker_loop() {
+        long long seen = 0;
+        while (true) {
+            const function<void(int)>* fn;
+            int count;
+            {
+                unique_lock<mutex> lock(mtx);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+                fn = job;
+                count = job_count;
+            }
+            run_tasks(*fn, count);
+            {
+                lock_guard<mutex> lock(mtx);
+                if (--busy == 0) done.notify_one();
+            }
+        }
+    }
+};
+
+// Row chunks handed out per worker thread; more chunks than threads lets fast threads take over
+const int EDGE_CHUNKS_PER_THREAD = 8;
+
+// Split rows [0, V) of the upper triangle into chunks for the pool. Row i owns the pairs (i, j > i),
+// so rows shrink towards the end; chunks hold roughly equal numbers of pairs instead of rows.
+// Returns chunk boundaries: chunk k covers rows [row_begin[k], row_begin[k + 1]).
+vector<int> balanced_row_chunks(int V, const ThreadPool& pool) {
+    long long total_pairs = (long long)V * (V - 1) / 2;
+    int chunks = max(1, min(V, pool.size() * EDGE_CHUNKS_PER_THREAD));
+    vector<int> row_begin{0};
+    long long pairs_so_far = 0;
+    for (int i = 0; i < V; ++i) {
+        pairs_so_far += V - 1 - i;
+        if (pairs_so_far * chunks >= total_pairs * (long long)row_begin.size() && i + 1 < V) row_begin.push_back(i + 1);
+    }
+    row_begin.push_back(V);
+    return row_begin;
+}
+
+// Eagerly test every vertex pair and store the safe arcs in the V x V matrix adj_aux (of type D).
+// The pool hands out balanced row chunks dynamically. Every pair is written by exactly one task
+// (both mirror cells), so no synchronization is needed.
+template <typename T, typename D>
+void build_safe_arc_graph(const SafeArcTester<T>& tester, DistMatrix<D>& adj_aux, ThreadPool& pool) {
+    int V = tester.vertices.size();
+    adj_aux = DistMatrix<D>(V);
+
+    vector<int> row_begin = balanced_row_chunks(V, pool);
+    pool.parallel_for((int)row_begin.size() - 1, [&](int chunk) {
+        ArcScratch<T> scratch;
+        for (int i = row_begin[chunk]; i < row_begin[chunk + 1]; ++i) {
             adj_aux[i][i] = 0;
+            for (int j = i + 1; j < V; ++j) {
+                adj_aux[i][j] = adj_aux[j][i] = tester.safe_length(i, j, scratch);
+            }
         }
+    });
+}
 
-        // Build auxiliary graph with safe arcs
-        for (int i = 0; i < V; ++i) {
+// Safe arcs in compressed sparse row form: the arcs of vertex u are col/len[row_start[u] ..
+// row_start[u + 1]). Memory grows with the number of safe arcs rather than with V^2.
+template <typename T>
+struct CsrGraph {
+    vector<int> row_start;
+    vector<int> col;
+    vector<T> len;
+
+    int size() const { return (int)row_start.size() - 1; }
+};
+
+// Test every vertex pair like build_safe_arc_graph, but keep only the safe arcs, as a CsrGraph.
+// Pass 1 records the verdicts as one bit per pair (row i holds j > i, so each row is written by a
+// single task); pass 2 sizes the rows from the bits and fills them with the arc lengths. Rows come
+// out sorted by neighbour, independent of the thread count.
+template <typename T, typename D>
+void build_safe_arc_csr(const SafeArcTester<T>& tester, CsrGraph<D>& graph, ThreadPool& pool) {
+    int V = tester.vertices.size();
+    size_t words = (V + 63) / 64;
+    vector<uint64_t> safe_bits(V * words, 0);
+
+    vector<int> row_begin = balanced_row_chunks(V, pool);
+    pool.parallel_for((int)row_begin.size() - 1, [&](int chunk) {
+        ArcScratch<T> scratch;
+        for (int i = row_begin[chunk]; i < row_begin[chunk + 1]; ++i) {
+            uint64_t* row = &safe_bits[i * words];
             for (int j = i + 1; j < V; ++j) {
-                // Optimization: if endpoints are identical or antipodal, arc safety is trivial
-                long double d_ij = dist_xyz(vertices[i], vertices[j]);
-                bool safe = false;
-                if (d_ij < EPS) { // Same point
-                    safe = true;
-                } else if (abs(d_ij - R_EARTH * PI) < EPS) { // Antipodal points
-                    // Check if antipodal arc is covered - this needs separate logic or is impossible?
-                    // Union of spheres condition. If the whole sphere is covered, yes.
-                    // Check if midpoint of ANY airport-antipodal airport arc is within R of ANY airport?
-                    // This case is complex, maybe not required by test cases or covered by general logic.
-                    // Assume for now that standard arc safety covers this.
-                     safe = is_arc_safe(vertices[i], vertices[j], airports_xyz, R);
-                }
-                else {
-                    safe = is_arc_safe(vertices[i], vertices[j], airports_xyz, R);
-                }
+                if (tester.safe_length(i, j, scratch) != INF<T>) row[j / 64] |= uint64_t(1) << (j % 64);
+            }
+        }
+    });
 
-                if (safe) {
-                    adj_aux[i][j] = adj_aux[j][i] = d_ij;
-                }
+    // Calls fn(i, j) for every safe pair i < j, in row-major order
+    auto for_each_safe = [&](auto fn) {
+        for (int i = 0; i < V; ++i) {
+            const uint64_t* row = &safe_bits[i * words];
+            for (size_t w = 0; w < words; ++w) {
+                for (uint64_t bits = row[w]; bits; bits &= bits - 1) fn(i, int(w * 64 + __builtin_ctzll(bits)));
             }
         }
+    };
 
-        // Floyd-Warshall on auxiliary graph to find shortest safe path between any two vertices
-        for (int k = 0; k < V; ++k) {
-            for (int i = 0; i < V; ++i) {
-                for (int j = 0; j < V; ++j) {
-                    if (adj_aux[i][k] != INF && adj_aux[k][j] != INF) {
-                        adj_aux[i][j] = min(adj_aux[i][j], adj_aux[i][k] + adj_aux[k][j]);
-                    }
+    graph.row_start.assign(V + 1, 0);
+    for_each_safe([&](int i, int j) { ++graph.row_start[i + 1]; ++graph.row_start[j + 1]; });
+    for (int v = 0; v < V; ++v) graph.row_start[v + 1] += graph.row_start[v];
+    graph.col.resize(graph.row_start[V]);
+    graph.len.resize(graph.row_start[V]);
+    vector<int> fill(graph.row_start.begin(), graph.row_start.end() - 1);
+    for_each_safe([&](int i, int j) {
+        T d = acos(tester.cos_between(i, j)) * R_EARTH<T>; // The length safe_length reported
+        graph.col[fill[i]] = j; graph.len[fill[i]++] = d;
+        graph.col[fill[j]] = i; graph.len[fill[j]++] = d;
+    });
+}
+
+// Blocked (tiled) Floyd-Warshall: per diagonal tile, close it, then its row/column, then the rest.
+// Tiles within phases 2 and 3 are independent, so they are spread over the pool; every tile
+// sees exactly the same sequence of relaxations as in a serial run, keeping results bit-identical.
+template <typename T>
+void floyd_warshall_blocked(DistMatrix<T>& dist, ThreadPool& pool) {
+    int n = dist.n;
+    int blocks = (n + FW_BLOCK - 1) / FW_BLOCK;
+    for (int kb = 0; kb < n; kb += FW_BLOCK) {
+        // Phase 1: diagonal tile depends only on itself
+        fw_relax_tile(dist, kb, kb, kb);
+
+        // Phase 2: tiles sharing the pivot row or column
+        pool.parallel_for(2 * blocks, [&](int task) {
+            int b = (task / 2) * FW_BLOCK;
+            if (b == kb) return;
+            if (task % 2 == 0) fw_relax_tile(dist, kb, b, kb);
+            else fw_relax_tile(dist, b, kb, kb);
+        });
+
+        // Phase 3: all remaining tiles, using the finished pivot row and column
+        pool.parallel_for(blocks * blocks, [&](int task) {
+            int ib = (task / blocks) * FW_BLOCK;
+            int jb = (task % blocks) * FW_BLOCK;
+            if (ib == kb || jb == kb) return;
+            fw_relax_tile(dist, ib, jb, kb);
+        });
+    }
+}
+
+// Dense O(N^2) refuel Dijkstra over the airport distance matrix from `source`, using only legs of
+// length <= c. Settles every reachable airport, since RefuelCache keeps the whole vector. Unreached stay INF.
+template <typename T>
+void dense_dijkstra(const DistMatrix<T>& airport_dist, int source, T c, vector<T>& dist) {
+    int n = airport_dist.n;
+    T limit = c + EPS<T>;
+    dist.assign(n, INF<T>);
+    vector<char> settled(n, 0);
+    dist[source] = 0;
+    for (int it = 0; it < n; ++it) {
+        int u = -1;
+        T best = INF<T>;
+        for (int i = 0; i < n; ++i) {
+            if (!settled[i] && dist[i] < best) { best = dist[i]; u = i; }
+        }
+        if (u < 0) break;
+        settled[u] = 1;
+
+        // Settled airports already hold dist <= best, so relaxing them is a no-op
+        const T* row_u = airport_dist[u];
+        for (int v = 0; v < n; ++v) {
+            if (row_u[v] > limit) continue;
+            T via = best + row_u[v];
+            if (via < dist[v]) dist[v] = via;
+        }
+    }
+}
+
+// Airport-to-airport safe distances from one heap Dijkstra per airport over the sparse safe-arc
+// graph: O(N E log V) instead of the O(V^3) Floyd-Warshall, since only airport rows are ever read.
+// Each search stops once every airport vertex is settled.
+template <typename T>
+void airport_distances_dijkstra(const CsrGraph<T>& graph, const vector<int>& airport_to_vertex_idx,
+                                DistMatrix<T>& airport_dist, ThreadPool& pool) {
+    int n = airport_to_vertex_idx.size();
+    int V = graph.size();
+    vector<char> is_airport(V, 0);
+    for (int v : airport_to_vertex_idx) is_airport[v] = 1;
+    int airport_vertices = count(is_airport.begin(), is_airport.end(), 1);
+
+    airport_dist = DistMatrix<T>(n);
+    pool.parallel_for(n, [&](int i) {
+        vector<T> dist(V, INF<T>);
+        vector<char> settled(V, 0);
+        priority_queue<pair<T, int>, vector<pair<T, int>>, greater<pair<T, int>>> heap;
+        dist[airport_to_vertex_idx[i]] = 0;
+        heap.push({0, airport_to_vertex_idx[i]});
+        for (int remaining = airport_vertices; remaining > 0 && !heap.empty(); ) {
+            auto [d, u] = heap.top();
+            heap.pop();
+            if (settled[u]) continue; // Stale entry
+            settled[u] = 1;
+            if (is_airport[u]) --remaining;
+
+            for (int e = graph.row_start[u]; e < graph.row_start[u + 1]; ++e) {
+                int v = graph.col[e];
+                T via = d + graph.len[e];
+                if (via < dist[v]) {
+                    dist[v] = via;
+                    heap.push({via, v});
                 }
             }
         }
+        for (int j = 0; j < n; ++j) airport_dist[i][j] = dist[airport_to_vertex_idx[j]];
+    });
+}
 
-        cin >> Q;
-        cout << "Case " << case_num++ << ":" << endl;
+// Airport-to-airport safe distances by Dijkstra over a LazyArcGraph. An arc is only tested when
+// it would improve its far end (arcs longer than the current best are never tested), and each
+// search stops once every airport vertex is settled. Distances match the eager dense Dijkstra.
+template <typename T, typename D>
+void airport_distances_lazy(LazyArcGraph<T, D>& graph, const vector<int>& airport_to_vertex_idx,
+                            DistMatrix<D>& airport_dist, ThreadPool& pool) {
+    int n = airport_to_vertex_idx.size();
+    int V = graph.size();
+    vector<char> is_airport(V, 0);
+    for (int v : airport_to_vertex_idx) is_airport[v] = 1;
+    int airport_vertices = count(is_airport.begin(), is_airport.end(), 1);
+
+    airport_dist = DistMatrix<D>(n);
+    pool.parallel_for(n, [&](int i) {
+        vector<D> dist(V, INF<D>);
+        vector<char> settled(V, 0);
+        ArcScratch<T> scratch;
+        dist[airport_to_vertex_idx[i]] = 0;
+        for (int remaining = airport_vertices; remaining > 0; ) {
+            int u = -1;
+            D best = INF<D>;
+            for (int k = 0; k < V; ++k) {
+                if (!settled[k] && dist[k] < best) { best = dist[k]; u = k; }
+            }
+            if (u < 0) break;
+            settled[u] = 1;
+            if (is_airport[u]) --remaining;
 
-        for (int q = 0; q < Q; ++q) {
-            int s, t;
-            long double c;
-            cin >> s >> t >> c;
-            --s; --t; // 0-indexed airports
+            for (int v = 0; v < V; ++v) {
+                D via = best + graph.length(u, v);
+                if (via < dist[v] && graph.safe(u, v, scratch)) dist[v] = via;
+            }
+        }
+        for (int j = 0; j < n; ++j) airport_dist[i][j] = dist[airport_to_vertex_idx[j]];
+    });
+}
 
-            // Build refueling graph (only airports as vertices) for the current fuel capacity c
-            vector<vector<long double>> current_adj_refuel(N, vector<long double>(N, INF));
-            for(int i = 0; i < N; ++i) current_adj_refuel[i][i] = 0;
+// Kruskal reconstruction tree over the airports: leaves are airports, and each internal node joins
+// two components by the leg that first connected them, carrying that leg's length. The lowest
+// common ancestor of s and t thus holds the minimax leg over all s -> t routes, found in O(log N)
+// by binary lifting. A leg i-j is taken as the shorter of the two directed distances, so a route
+// the directed search can use never has a larger bottleneck here.
+template <typename T>
+class BottleneckTree {
+public:
+    explicit BottleneckTree(const DistMatrix<T>& airport_dist) {
+        int n = airport_dist.n;
+        struct Leg { T w; int a, b; };
+        vector<Leg> legs;
+        for (int i = 0; i < n; ++i) {
+            for (int j = i + 1; j < n; ++j) {
+                T w = min(airport_dist[i][j], airport_dist[j][i]);
+                if (w != INF<T>) legs.push_back({w, i, j});
+            }
+        }
+        sort(legs.begin(), legs.end(), [](const Leg& x, const Leg& y) { return x.w < y.w; });
+
+        // Union-find over airports; top[root] is the tree node currently standing for that set
+        vector<int> set_parent(n), top(n);
+        for (int i = 0; i < n; ++i) set_parent[i] = top[i] = i;
+        auto find = [&](int x) {
+            while (set_parent[x] != x) x = set_parent[x] = set_parent[set_parent[x]];
+            return x;
+        };
+        weight.assign(n, 0);
+        vector<int> parent(n, -1);
+        for (const Leg& leg : legs) {
+            int a = find(leg.a), b = find(leg.b);
+            if (a == b) continue;
+            int node = weight.size();
+            weight.push_back(leg.w);
+            parent.push_back(-1);
+            parent[top[a]] = parent[top[b]] = node;
+            set_parent[a] = b;
+            top[b] = node;
+        }
 
-            for(int i = 0; i < N; ++i) {
-                for(int j = 0; j < N; ++j) {
-                    if (i == j) continue;
-                    int u_idx = airport_to_vertex_idx[i];
-                    int v_idx = airport_to_vertex_idx[j];
-                    // Edge exists between airports i and j if the shortest safe path in the aux graph is <= fuel capacity c
-                    if (adj_aux[u_idx][v_idx] <= c + EPS) {
-                        current_adj_refuel[i][j] = adj_aux[u_idx][v_idx];
-                    }
-                }
+        // Parents always have larger ids than their children, so one downward pass sets depths
+        int nodes = weight.size();
+        depth.assign(nodes, 0);
+        int levels = 1;
+        while ((1 << levels) < nodes) ++levels;
+        up.assign(levels, vector<int>(nodes));
+        for (int v = nodes - 1; v >= 0; --v) {
+            up[0][v] = parent[v] < 0 ? v : parent[v];
+            depth[v] = parent[v] < 0 ? 0 : depth[parent[v]] + 1;
+        }
+        for (int k = 1; k < levels; ++k) {
+            for (int v = 0; v < nodes; ++v) up[k][v] = up[k - 1][up[k - 1][v]];
+        }
+    }
+
+    // Smallest achievable longest leg over all routes s -> t: 0 if s == t, INF if disconnected
+    T bottleneck(int s, int t) const {
+        if (depth[s] < depth[t]) swap(s, t);
+        for (int k = (int)up.size() - 1; k >= 0; --k) {
+            if (depth[s] - (1 << k) >= depth[t]) s = up[k][s];
+        }
+        if (s == t) return weight[s];
+        for (int k = (int)up.size() - 1; k >= 0; --k) {
+            if (up[k][s] != up[k][t]) { s = up[k][s]; t = up[k][t]; }
+        }
+        if (up[0][s] == s) return INF<T>; // Different trees of the forest
+        return weight[up[0][s]];
+    }
+
+private:
+    vector<T> weight; // Leg length per node; 0 for the airport leaves
+    vector<int> depth;
+    vector<vector<int>> up; // up[k][v] = 2^k-th ancestor of v (roots point to themselves)
+};
+
+// Memoizes single-source refuel distances per (capacity bucket, source). The refuel graph only
+// changes when c crosses one of the sorted airport-pair distances, so all c in a bucket share it.
+template <typename T>
+class RefuelCache {
+public:
+    explicit RefuelCache(const DistMatrix<T>& airport_dist) : airport_dist(airport_dist), tree(airport_dist) {
+        int n = airport_dist.n;
+        for (int i = 0; i < n; ++i) {
+            for (int j = 0; j < n; ++j) {
+                if (i != j && airport_dist[i][j] != INF<T>) thresholds.push_back(airport_dist[i][j]);
             }
+        }
+        sort(thresholds.begin(), thresholds.end());
+        thresholds.erase(unique(thresholds.begin(), thresholds.end()), thresholds.end());
+    }
 
-            // Floyd-Warshall on the airport graph to find shortest path with refueling stops
-            for (int k = 0; k < N; ++k) {
-                for (int i = 0; i < N; ++i) {
-                    for (int j = 0; j < N; ++j) {
-                        if (current_adj_refuel[i][k] != INF && current_adj_refuel[k][j] != INF) {
-                             current_adj_refuel[i][j] = min(current_adj_refuel[i][j], current_adj_refuel[i][k] + current_adj_refuel[k][j]);
-                        }
-                    }
+    // Shortest refuel distance s -> t with capacity c; INF when unreachable
+    T query(int s, int t, T c) {
+        // Every route needs a leg longer than c: impossible without any shortest-path work
+        if (tree.bottleneck(s, t) > c + EPS<T>) return INF<T>;
+        // Bucket = number of distinct leg lengths that fit in c (same test as dense_dijkstra)
+        long long bucket = upper_bound(thresholds.begin(), thresholds.end(), c + EPS<T>) - thresholds.begin();
+        vector<T>& dist = memo[bucket * airport_dist.n + s];
+        if (dist.empty()) dense_dijkstra(airport_dist, s, c, dist);
+        return dist[t];
+    }
+
+private:
+    const DistMatrix<T>& airport_dist;
+    BottleneckTree<T> tree;
+    vector<T> thresholds;
+    unordered_map<long long, vector<T>> memo;
+};
+
+// One refueling query: airports s -> t (0-indexed) with fuel capacity c
+template <typename T>
+struct Query {
+    int s, t;
+    T c;
+};
+
+// Offline answering: sort queries by c and insert airport legs in increasing length, keeping
+// all-pairs refuel distances current with an O(N^2) update per inserted leg. Fills answers[q].
+template <typename T, typename D>
+void answer_queries_offline(const DistMatrix<D>& airport_dist, const vector<Query<T>>& queries, vector<D>& answers) {
+    int n = airport_dist.n;
+
+    struct Leg { D w; int from, to; };
+    vector<Leg> legs;
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+            if (i != j && airport_dist[i][j] != INF<D>) legs.push_back({airport_dist[i][j], i, j});
+        }
+    }
+    sort(legs.begin(), legs.end(), [](const Leg& a, const Leg& b) { return a.w < b.w; });
+
+    vector<int> order(queries.size());
+    for (size_t q = 0; q < order.size(); ++q) order[q] = (int)q;
+    stable_sort(order.begin(), order.end(), [&](int a, int b) { return queries[a].c < queries[b].c; });
+
+    DistMatrix<D> refuel(n);
+    for (int i = 0; i < n; ++i) refuel[i][i] = 0;
+
+    answers.assign(queries.size(), INF<D>);
+    size_t next_leg = 0;
+    for (int q : order) {
+        // Insert every leg that fits in this query's tank
+        for (; next_leg < legs.size() && legs[next_leg].w <= (D)queries[q].c + EPS<D>; ++next_leg) {
+            const Leg& leg = legs[next_leg];
+            if (refuel[leg.from][leg.to] <= leg.w) continue; // Already a path at least as short
+            for (int i = 0; i < n; ++i) {
+                D d_in = refuel[i][leg.from];
+                if (d_in == INF<D>) continue;
+                D* row_i = refuel[i];
+                const D* row_to = refuel[leg.to];
+                for (int j = 0; j < n; ++j) {
+                    D via = d_in + leg.w + row_to[j];
+                    if (via < row_i[j]) row_i[j] = via;
                 }
             }
+        }
+        answers[q] = refuel[queries[q].s][queries[q].t];
+    }
+}
+
+// Command-line tunables; the defaults reproduce the original single-threaded run
+struct Options {
+    int threads = 1; // --threads N, 0 = one per hardware thread
+    bool batch = false; // --batch: answer each case's queries offline, sorted by fuel capacity
+    string precision = "long"; // --precision float|double|long: scalar type of the whole solver
+    string apsp = "fw"; // --apsp fw|dijkstra|lazy: Floyd-Warshall, sparse Dijkstra per airport, or lazy arcs
+    bool pipeline = false; // --pipeline: solve whole cases concurrently, one per thread
+    string storage; // --storage float|double|long: scalar type of distance matrices and sums; default: as --precision
+};
 
-            if (current_adj_refuel[s][t] == INF) {
-                cout << "impossible" << endl;
-            } else {
-                cout << current_adj_refuel[s][t] << endl;
+// Upper bound for --threads; larger requests are capped to it
+const int MAX_THREADS = 1024;
+
+bool parse_options(int argc, char* argv[], Options& opts) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        string value;
+        size_t eq = arg.find('=');
+        if (eq != string::npos) {
+            value = arg.substr(eq + 1);
+            arg = arg.substr(0, eq);
+        } else if (i + 1 < argc) {
+            value = argv[i + 1];
+        }
+
+        if (arg == "--batch" && eq == string::npos) {
+            opts.batch = true;
+        } else if (arg == "--pipeline" && eq == string::npos) {
+            opts.pipeline = true;
+        } else if (arg == "--apsp") {
+            if (value != "fw" && value != "dijkstra" && value != "lazy") {
+                cerr << "--apsp expects fw, dijkstra or lazy" << endl;
+                return false;
+            }
+            opts.apsp = value;
+            if (eq == string::npos) ++i;
+        } else if (arg == "--precision") {
+            if (value != "float" && value != "double" && value != "long") {
+                cerr << "--precision expects float, double or long" << endl;
+                return false;
+            }
+            opts.precision = value;
+            if (eq == string::npos) ++i;
+        } else if (arg == "--storage") {
+            if (value != "float" && value != "double" && value != "long") {
+                cerr << "--storage expects float, double or long" << endl;
+                return false;
             }
+            opts.storage = value;
+            if (eq == string::npos) ++i;
+        } else if (arg == "--threads") {
+            if (value.empty() || value.find_first_not_of("0123456789") != string::npos) {
+                cerr << "--threads expects a non-negative integer" << endl;
+                return false;
+            }
+            auto result = from_chars(value.data(), value.data() + value.size(), opts.threads);
+            // Digits only, so the sole failure left is a count too large for int
+            if (result.ec != errc() || opts.threads > MAX_THREADS) opts.threads = MAX_THREADS;
+            if (opts.threads == 0) opts.threads = max(1u, thread::hardware_concurrency());
+            if (eq == string::npos) ++i;
+        } else {
+            cerr << "Unknown option: " << argv[i] << endl;
+            cerr << "Usage: " << argv[0] << " [--threads N] [--batch] [--pipeline] [--precision float|double|long] [--storage float|double|long] [--apsp fw|dijkstra|lazy]" << endl;
+            return false;
         }
     }
+    return true;
+}
+
+// One parsed test case: airports as R_EARTH-scaled points (normalized later by UnitStore),
+// safety radius R and the queries
+template <typename T>
+struct CaseInput {
+    vector<Point<T>> airports_xyz;
+    T R;
+    vector<Query<T>> queries;
+};
+
+// Buffered whitespace-separated token reader over a FILE*, parsing numbers with from_chars.
+// Replaces iostream extraction, whose per-token locale and sentry overhead dominates on large inputs.
+class InputReader {
+public:
+    explicit InputReader(FILE* file) : file(file), buf(1 << 16) {}
+
+    // Parse the next token into value; false at end of input or if the token is not a number
+    template <typename V>
+    bool read(V& value) {
+        if (!next_token()) return false;
+        if (*token_begin == '+') ++token_begin; // from_chars rejects an explicit plus sign
+        auto result = from_chars(token_begin, token_end, value);
+        return result.ec == errc() && result.ptr == token_end;
+    }
+
+private:
+    FILE* file;
+    vector<char> buf;
+    size_t pos = 0, len = 0;
+    bool eof = false;
+    const char* token_begin = nullptr;
+    const char* token_end = nullptr;
+
+    static bool is_space(char ch) { return ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t' || ch == '\v' || ch == '\f'; }
+
+    // Append whatever fits after buf[len]; false once the file is exhausted
+    bool fill() {
+        if (eof) return false;
+        size_t got = fread(buf.data() + len, 1, buf.size() - len, file);
+        if (got == 0) eof = true;
+        len += got;
+        return got > 0;
+    }
+
+    bool next_token() {
+        while (true) {
+            while (pos < len && is_space(buf[pos])) ++pos;
+            if (pos < len) break;
+            pos = len = 0;
+            if (!fill()) return false;
+        }
+        size_t start = pos;
+        while (true) {
+            while (pos < len && !is_space(buf[pos])) ++pos;
+            if (pos < len || eof) break;
+            // Token runs into the end of the buffer: move it to the front and read more
+            len -= start;
+            pos -= start;
+            copy(buf.begin() + start, buf.begin() + start + len, buf.begin());
+            start = 0;
+            if (len == buf.size()) buf.resize(2 * buf.size());
+            fill();
+        }
+        token_begin = buf.data() + start;
+        token_end = buf.data() + pos;
+        return true;
+    }
+};
+
+// Read the next case from in; false at end of input, or (with a message on stderr) when the
+// case is truncated or holds a malformed token
+template <typename T>
+bool read_case(InputReader& in, CaseInput<T>& c) {
+    int N = 0, Q = 0;
+    if (!in.read(N)) return false;
+    bool ok = N >= 0 && in.read(c.R);
+    if (ok) c.airports_xyz.resize(N);
+    for (int i = 0; ok && i < N; ++i) {
+        T lat = 0, lon = 0;
+        ok = in.read(lon) && in.read(lat); // Input is lon lat
+        c.airports_xyz[i] = lat_lon_to_xyz(lat, lon);
+    }
+    ok = ok && in.read(Q) && Q >= 0;
+    if (ok) c.queries.resize(Q);
+    for (int q = 0; ok && q < Q; ++q) {
+        auto& query = c.queries[q];
+        ok = in.read(query.s) && in.read(query.t) && in.read(query.c) &&
+             query.s >= 1 && query.s <= N && query.t >= 1 && query.t <= N;
+        --query.s; --query.t; // 0-indexed airports
+    }
+    if (!ok) cerr << "Malformed or truncated input case" << endl;
+    return ok;
+}
+
+// Answer every query of one case (INF = impossible). Geometry runs in T; distances are stored and
+// summed in D. vertex_grid and airport_to_vertex_idx are scratch storage kept from case to case.
+template <typename T, typename D>
+vector<D> solve_case(const CaseInput<T>& c, const Options& opts, ThreadPool& pool,
+                     VertexGrid<T>& vertex_grid, vector<int>& airport_to_vertex_idx) {
+    int N = c.airports_xyz.size();
+    UnitStore<T> unit_airports(c.airports_xyz);
+    build_vertices(c.airports_xyz, unit_airports.unit, c.R, vertex_grid, airport_to_vertex_idx);
+    const vector<Point<T>>& vertices = vertex_grid.points();
+    UnitStore<T> unit_vertices(vertices);
+    AirportIndex<T> airport_index(unit_airports.unit);
+    SafeArcTester<T> tester{unit_vertices, unit_airports.unit, airport_index, c.R};
+
+    // Safe distances between airports only; this is all the query phase needs
+    DistMatrix<D> airport_dist(N);
+    if (opts.apsp == "lazy") {
+        LazyArcGraph<T, D> graph(tester);
+        airport_distances_lazy(graph, airport_to_vertex_idx, airport_dist, pool);
+    } else if (opts.apsp == "dijkstra") {
+        // Sparse auxiliary graph with only the safe arcs
+        CsrGraph<D> graph;
+        build_safe_arc_csr(tester, graph, pool);
+        airport_distances_dijkstra(graph, airport_to_vertex_idx, airport_dist, pool);
+    } else {
+        // Build auxiliary graph with safe arcs
+        DistMatrix<D> adj_aux;
+        build_safe_arc_graph(tester, adj_aux, pool);
+
+        // Floyd-Warshall on auxiliary graph to find shortest safe path between any two vertices
+        floyd_warshall_blocked(adj_aux, pool);
+        for (int i = 0; i < N; ++i) {
+            for (int j = 0; j < N; ++j) {
+                airport_dist[i][j] = adj_aux[airport_to_vertex_idx[i]][airport_to_vertex_idx[j]];
+            }
+        }
+    }
+
+    const vector<Query<T>>& queries = c.queries;
+    vector<D> answers(queries.size());
+    if (opts.batch) {
+        answer_queries_offline(airport_dist, queries, answers);
+    } else {
+        // Shortest path with refueling stops; legs are airport pairs whose safe distance fits in c
+        RefuelCache<D> cache(airport_dist);
+        for (size_t q = 0; q < queries.size(); ++q) {
+            answers[q] = cache.query(queries[q].s, queries[q].t, (D)queries[q].c);
+        }
+    }
+    return answers;
+}
+
+// Append value to out exactly as printf("%.3Lf") would. Away from a rounding tie the digits come
+// from one scaled integer; within 1e-3 of a tie (where the scaling error could matter), for huge
+// values and for negative zero, to_chars takes over. scaled has <= 2^-13 absolute error below 1e12.
+template <typename T>
+void append_fixed3(string& out, T value) {
+    long double scaled = (long double)value * 1000;
+    long double whole = floor(scaled);
+    long double frac = scaled - whole;
+    if (!signbit(value) && value < (T)1e12 && fabs(frac - 0.5L) > 1e-3L) {
+        unsigned long long n = (unsigned long long)whole + (frac > 0.5L);
+        char digits[24];
+        char* p = digits + sizeof digits;
+        for (int k = 0; k < 3; ++k, n /= 10) *--p = char('0' + n % 10);
+        *--p = '.';
+        do { *--p = char('0' + n % 10); n /= 10; } while (n);
+        out.append(p, digits + sizeof digits);
+        return;
+    }
+    // Sign, up to max_exponent10 + 1 integer digits, the point and three decimals always fit
+    char digits[numeric_limits<T>::max_exponent10 + 8];
+    auto result = to_chars(digits, digits + sizeof digits, value, chars_format::fixed, 3);
+    out.append(digits, result.ptr);
+}
+
+// Append the output block of one case to out: the "Case k:" header, then one answer per line
+template <typename T>
+void format_case(int case_num, const vector<T>& answers, string& out) {
+    out += "Case ";
+    out += to_string(case_num);
+    out += ":\n";
+    for (T answer : answers) {
+        if (answer == INF<T>) {
+            out += "impossible\n";
+        } else {
+            append_fixed3(out, answer);
+            out += '\n';
+        }
+    }
+}
+
+// Write a finished block to stdout and flush it
+void write_block(const string& block) {
+    fwrite(block.data(), 1, block.size(), stdout);
+    fflush(stdout);
+}
+
+// Solve every case on stdin with scalar type T and distance type D, one after another
+template <typename T, typename D>
+void run_cases(const Options& opts, ThreadPool& pool) {
+    // Vertex storage is reused from case to case
+    VertexGrid<T> vertex_grid;
+    vector<int> airport_to_vertex_idx;
+
+    InputReader in(stdin);
+    CaseInput<T> c;
+    string block; // Output buffer, reused; written once per case
+    for (int case_num = 1; read_case(in, c); ++case_num) {
+        block.clear();
+        format_case(case_num, solve_case<T, D>(c, opts, pool, vertex_grid, airport_to_vertex_idx), block);
+        write_block(block);
+    }
+}
+
+// Bounded FIFO between the case reader and the solver threads
+template <typename Item>
+class BlockingQueue {
+public:
+    explicit BlockingQueue(size_t capacity) : capacity(capacity) {}
+
+    // Blocks while the queue is full
+    void push(Item item) {
+        unique_lock<mutex> lock(mtx);
+        not_full.wait(lock, [this] { return items.size() < capacity; });
+        items.push_back(move(item));
+        not_empty.notify_one();
+    }
+
+    // Blocks until an item is available; false once the queue is closed and drained
+    bool pop(Item& item) {
+        unique_lock<mutex> lock(mtx);
+        not_empty.wait(lock, [this] { return closed || !items.empty(); });
+        if (items.empty()) return false;
+        item = move(items.front());
+        items.pop_front();
+        not_full.notify_one();
+        return true;
+    }
+
+    void close() {
+        lock_guard<mutex> lock(mtx);
+        closed = true;
+        not_empty.notify_all();
+    }
+
+private:
+    size_t capacity;
+    deque<Item> items;
+    mutex mtx;
+    condition_variable not_empty, not_full;
+    bool closed = false;
+};
+
+// Writes case blocks to stdout in case order, whichever thread finishes them first
+class OrderedWriter {
+public:
+    void submit(int case_num, string block) {
+        lock_guard<mutex> lock(mtx);
+        pending[case_num] = move(block);
+        for (auto it = pending.find(next_case); it != pending.end(); it = pending.find(next_case)) {
+            write_block(it->second);
+            pending.erase(it);
+            ++next_case;
+        }
+    }
+
+private:
+    mutex mtx;
+    unordered_map<int, string> pending;
+    int next_case = 1;
+};
+
+// Case-level pipeline (--pipeline): this thread parses whole cases into a bounded queue,
+// opts.threads solver threads each take a case and solve it on their own (with a serial pool),
+// and the ordered writer prints the blocks in input order.
+template <typename T, typename D>
+void run_cases_pipelined(const Options& opts) {
+    int workers = opts.threads;
+    BlockingQueue<pair<int, CaseInput<T>>> cases(2 * workers);
+    OrderedWriter writer;
+
+    vector<thread> solvers;
+    for (int w = 0; w < workers; ++w) {
+        solvers.emplace_back([&] {
+            ThreadPool serial(1);
+            VertexGrid<T> vertex_grid;
+            vector<int> airport_to_vertex_idx;
+            pair<int, CaseInput<T>> item;
+            while (cases.pop(item)) {
+                vector<D> answers = solve_case<T, D>(item.second, opts, serial, vertex_grid, airport_to_vertex_idx);
+                string block;
+                format_case(item.first, answers, block);
+                writer.submit(item.first, move(block));
+            }
+        });
+    }
+
+    InputReader in(stdin);
+    CaseInput<T> c;
+    for (int case_num = 1; read_case(in, c); ++case_num) cases.push({case_num, move(c)});
+    cases.close();
+    for (auto& solver : solvers) solver.join();
+}
+
+// Pick the distance type D for geometry type T and run every case.
+// Error bound of a narrower --storage against the default long double run: each arc length is
+// rounded once to D (relative error u = 2^-24 for float, 2^-53 for double) and a path of k arcs is
+// summed in D, so a printed answer d moves by at most k * u * d plus 0.001 km (one printed digit).
+// This holds while no leg is within u of a query's capacity c, since such a leg may be admitted or
+// dropped differently. test_cpp_solution.py checks the bound with k = 64.
+template <typename T>
+void run_with_storage(const Options& opts, ThreadPool& pool) {
+    if (opts.storage == "float") {
+        if (opts.pipeline) run_cases_pipelined<T, float>(opts);
+        else run_cases<T, float>(opts, pool);
+    } else if (opts.storage == "double") {
+        if (opts.pipeline) run_cases_pipelined<T, double>(opts);
+        else run_cases<T, double>(opts, pool);
+    } else if (opts.storage == "long") {
+        if (opts.pipeline) run_cases_pipelined<T, long double>(opts);
+        else run_cases<T, long double>(opts, pool);
+    } else {
+        if (opts.pipeline) run_cases_pipelined<T, T>(opts);
+        else run_cases<T, T>(opts, pool);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Options opts;
+    if (!parse_options(argc, argv, opts)) return 1;
+    // Case-level and in-case parallelism do not mix; a pipelined run keeps its workers busy with cases
+    ThreadPool pool(opts.pipeline ? 1 : opts.threads);
+
+    if (opts.precision == "float") run_with_storage<float>(opts, pool);
+    else if (opts.precision == "double") run_with_storage<double>(opts, pool);
+    else run_with_storage<long double>(opts, pool);
 
     return 0;
 }
\ No newline at end of file
@@ -8,7 +8,7 @@ def compile_cpp_solution():
     """Compile the C++ solution"""
     print("Compiling main.cpp...")
     result = subprocess.run(
-        ["g++", "-o", "main_cpp.exe", "main.cpp", "-std=c++17", "-O2"],
+        ["g++", "-o", "main_cpp.exe", "main.cpp", "-std=c++17", "-O2", "-pthread"],
         capture_output=True,
         text=True
     )
@@ -99,6 +99,45 @@ def run_test_case(input_file, expected_output_file, tolerance=1e-2):
         print(f"Reason: {message}")
         return False
 
+# Option sets whose output must match the default run byte for byte
+IDENTICAL_MODES = [
+    ["--threads", "4"],
+    ["--threads", "0"],
+    ["--batch"],
+    ["--precision", "double"],
+    ["--apsp", "dijkstra"],
+    ["--apsp", "lazy"],
+    ["--apsp", "lazy", "--threads", "4"],
+]
+
+def run_solution(input_data, args=()):
+    """Run the solution on input_data with extra command-line args; None on timeout or error"""
+    try:
+        result = subprocess.run(
+            ["./main_cpp.exe", *args],
+            input=input_data,
+            capture_output=True,
+            text=True,
+            timeout=60
+        )
+    except subprocess.TimeoutExpired:
+        return None
+    return result.stdout if result.returncode == 0 else None
+
+def check_identical_modes(input_file):
+    """Rerun input_file with every IDENTICAL_MODES option set and compare against the default run"""
+    with open(input_file, 'r') as f:
+        input_data = f.read()
+    baseline = run_solution(input_data)
+    ok = baseline is not None
+    for args in IDENTICAL_MODES:
+        if not ok:
+            break
+        if run_solution(input_data, args) != baseline:
+            print(f"❌ {input_file} - output with {' '.join(args)} differs from the default run")
+            ok = False
+    return ok
+
 def run_all_tests(tolerance=1e-2):
     """Run all test cases with given tolerance"""
     print(f"🔍 Testing C++ solution with tolerance: {tolerance}")
@@ -115,7 +154,7 @@ def run_all_tests(tolerance=1e-2):
         expected_file = input_file.with_suffix(".ans")
         if expected_file.exists():
             total += 1
-            if run_test_case(str(input_file), str(expected_file), tolerance):
+            if run_test_case(str(input_file), str(expected_file), tolerance) and check_identical_modes(str(input_file)):
                 passed += 1
             else:
                 failed_tests.append(input_file.name)
@@ -129,6 +168,70 @@ def run_all_tests(tolerance=1e-2):
     
     return passed == total
 
+# Relative rounding error u of each --storage type, and the longest path (in arcs) the bound
+# k * u * d + 0.001 km is checked for; see run_with_storage() in main.cpp
+STORAGE_UNIT_ROUNDOFF = {"double": 2.0 ** -53, "float": 2.0 ** -24}
+STORAGE_MAX_ARCS = 64
+
+def check_storage_bound(storage):
+    """Run every test with --storage and check answers against the documented error bound"""
+    rel_bound = STORAGE_MAX_ARCS * STORAGE_UNIT_ROUNDOFF[storage]
+    print(f"🔍 Checking --storage {storage} (|error| <= {rel_bound:.2e} * d + 0.001 km)")
+
+    passed = True
+    for input_file in sorted(Path("shortest").glob("*.in")):
+        expected_file = input_file.with_suffix(".ans")
+        if not expected_file.exists():
+            continue
+        with open(input_file, 'r') as f:
+            result = subprocess.run(
+                ["./main_cpp.exe", "--storage", storage],
+                stdin=f,
+                capture_output=True,
+                text=True,
+                timeout=60
+            )
+        with open(expected_file, 'r') as f:
+            expected_lines = f.read().strip().split('\n')
+        actual_lines = result.stdout.strip().split('\n')
+
+        message = None
+        if result.returncode != 0:
+            message = f"runtime error: {result.stderr.strip()}"
+        elif len(expected_lines) != len(actual_lines):
+            message = f"expected {len(expected_lines)} lines, got {len(actual_lines)}"
+        else:
+            for i, (exp_line, act_line) in enumerate(zip(expected_lines, actual_lines)):
+                exp_line, act_line = exp_line.strip(), act_line.strip()
+                if exp_line.startswith("Case") or exp_line == "impossible" or act_line == "impossible":
+                    if exp_line != act_line:
+                        message = f"Line {i+1}: expected '{exp_line}', got '{act_line}'"
+                        break
+                    continue
+                exp_val, act_val = float(exp_line), float(act_line)
+                if abs(exp_val - act_val) > rel_bound * abs(exp_val) + 0.001 + 1e-9:
+                    message = f"Line {i+1}: expected {exp_val:.3f}, got {act_val:.3f}"
+                    break
+
+        if message:
+            print(f"❌ {input_file} - FAILED ({message})")
+            passed = False
+        else:
+            print(f"✅ {input_file} - PASSED")
+    return passed
+
+def check_pipeline():
+    """Run all of shortest/ as one input with --pipeline --threads 4 and compare with the sequential run"""
+    print("🔍 Checking --pipeline --threads 4 on the concatenation of shortest/*.in")
+    input_data = "\n".join(path.read_text() for path in sorted(Path("shortest").glob("*.in")))
+    sequential = run_solution(input_data)
+    pipelined = run_solution(input_data, ["--pipeline", "--threads", "4"])
+    if sequential is None or pipelined != sequential:
+        print("❌ --pipeline output differs from the sequential run")
+        return False
+    print("✅ --pipeline output matches the sequential run")
+    return True
+
 def main():
     # Change to the script's directory (relative path handling)
     script_dir = os.path.dirname(os.path.abspath(__file__))
@@ -145,6 +248,13 @@ def main():
         print()
         if run_all_tests(tolerance):
             print(f"🎉 All tests passed with tolerance {tolerance}!")
+            print()
+            if not all(check_storage_bound(storage) for storage in STORAGE_UNIT_ROUNDOFF):
+                print("❌ Narrow --storage answers exceed the documented error bound!")
+                return 1
+            print()
+            if not check_pipeline():
+                return 1
             print("\n✅ C++ solution is working correctly!")
             return 0
         print()